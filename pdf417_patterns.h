@@ -0,0 +1,23 @@
+/* pdf417_patterns.h
+
+   The PDF417 codeword patterns (see pdf417_patterns.c).
+
+*/
+
+#ifndef _PDF417_PATTERNS_H_
+#define _PDF417_PATTERNS_H_
+
+#include "pdf417types.h"
+
+/* number of modules in a codeword */
+
+#define PDF417_MODULES  17
+
+/* start and stop patterns (the stop pattern without its final bar) */
+
+#define PDF417_START  0x1fea8  /* 8 1 1 1 1 1 1 3 */
+#define PDF417_STOP   0x1fd14  /* 7 1 1 3 1 1 1 2 */
+
+extern const UInt32 pdf417_patterns[3][929];
+
+#endif /*_PDF417_PATTERNS_H_*/
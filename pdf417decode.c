@@ -37,8 +37,13 @@
 
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
-#include "pbm.h"
+#include "pdf417decode.h"
+#include "pdf417image.h"
+#include "pdf417rs.h"
+#include "pdf417_dham.h"
 
 
 /* You may have to play with these numbers, depending on your scan quality */
@@ -46,100 +51,666 @@
 #define FUZZ_THRESH (cols/40)
 #define ROW_THRESH  (cols/20)
 
-typedef unsigned int UInt32;
-typedef int Int32;
+static void decode_segment(PDF417_CTX *ctx, int *cw, int len, int mode);
 
-/*  You'd better be using gcc, or else an Alpha, or something
- *  Your compiler needs to understand that "long long" is 64 bits (gcc does)
- *  in order to compile it.
+static void convert_byte(PDF417_CTX *ctx, int *cw, int len, int mode);
+static void convert_text(PDF417_CTX *ctx, int *cw, int len);
+static void convert_num(PDF417_CTX *ctx, int *cw, int len);
+
+
+
+/*-----------------------------------------------------------------*/
+
+void pdf417_init(PDF417_CTX *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->margin = PDF417_MARGIN;
+    pdf417_reset(ctx);
+}
+
+
+/* Clear the per-image state, keeping the options and the output buffer */
+
+void pdf417_reset(PDF417_CTX *ctx) {
+    ctx->numouts = 0;
+    ctx->numerasures = 0;
+    ctx->numunread = 0;
+    memset(ctx->cell, 0, sizeof(ctx->cell));
+    memset(ctx->rivotes, 0, sizeof(ctx->rivotes));
+    ctx->lastrow = -1;
+    ctx->nrows = ctx->ncols = 0;
+    ctx->ecl = -1;
+    ctx->numsynd = 0;
+    ctx->overflow = 0;
+    ctx->nomem = 0;
+    ctx->ioerr = 0;
+    ctx->outlen = 0;
+}
+
+
+void pdf417_free(PDF417_CTX *ctx) {
+    free(ctx->out);
+    ctx->out = NULL;
+    ctx->outlen = ctx->outsize = 0;
+
+    free(ctx->planes);
+    free(ctx->counts);
+    free(ctx->changes);
+    free(ctx->words);
+    free(ctx->cws);
+    ctx->planes = NULL;
+    ctx->counts = NULL;
+    ctx->changes = NULL;
+    ctx->words = NULL;
+    ctx->cws = NULL;
+    ctx->cumsize = 0;
+
+    if (ctx->rswork != NULL) rs_work_free(ctx->rswork);
+    free(ctx->rswork);
+    ctx->rswork = NULL;
+    free(ctx->scratch);
+    ctx->scratch = NULL;
+}
+
+
+PDF417_CTX *pdf417_new(void) {
+    PDF417_CTX *ctx = malloc(sizeof(PDF417_CTX));
+
+    if (ctx != NULL) pdf417_init(ctx);
+    return ctx;
+}
+
+
+void pdf417_delete(PDF417_CTX *ctx) {
+    if (ctx == NULL) return;
+    pdf417_free(ctx);
+    free(ctx);
+}
+
+
+/*
+ *  Scratch space for a whole symbol, kept in the context so the decoder
+ *  needs little stack: two arrays of MAX_CODEWORDS, used by one routine
+ *  at a time. Returns NULL (and sets nomem) if it cannot be allocated.
  */
 
-typedef unsigned long long UInt64;
+static Int32 *ctx_scratch(PDF417_CTX *ctx) {
+    if (ctx->scratch == NULL) {
+	ctx->scratch = malloc(2 * MAX_CODEWORDS * sizeof(Int32));
+	if (ctx->scratch == NULL) ctx->nomem = 1;
+    }
+    return ctx->scratch;
+}
 
-extern const unsigned dham[3][32768];
 
-int mask[15];
+/* The Reed-Solomon workspace, allocated on first use like the scratch */
 
-int debug = 0;
-int dump = 0;
-int encfmt = 0;
+static RS_WORK *ctx_rswork(PDF417_CTX *ctx) {
+    if (ctx->rswork == NULL) {
+	ctx->rswork = calloc(1, sizeof(RS_WORK));
+	if (ctx->rswork == NULL) ctx->nomem = 1;
+    }
+    return ctx->rswork;
+}
 
-Int32 codewords[34*90];  /* array for the extracted codewords */
-Int32 erasures[34*90];   /* for the Reed-Solomon correction routine */
-int numouts = 0;
-int numerasures = 0;
 
-void decode_segment(int *cw, int len, int mode);
+/* Make room for at least len more bytes in the output buffer */
 
-void convert_byte(int *cw, int len, int mode);
-void convert_text(int *cw, int len);
-void convert_num(int *cw, int len);
+static int out_grow(PDF417_CTX *ctx, size_t len) {
+    size_t size;
+    char *p;
 
-extern int eras_dec_rs(int data[], int eras_pos[], int no_eras,
-                       int data_len, int synd_len);
+    if (ctx->outsize - ctx->outlen >= len) return 0;
 
+    size = ctx->outsize ? ctx->outsize : 256;
+    while (size - ctx->outlen < len) size *= 2;
 
+    p = realloc(ctx->out, size);
+    if (p == NULL) {
+	ctx->nomem = 1;
+	return -1;
+    }
+    ctx->out = p;
+    ctx->outsize = size;
+    return 0;
+}
+
+
+/*
+ *  All the decoded data (and the debug output) goes to the output buffer.
+ *  The buffer is handed to the output sink, if there is one, once per
+ *  symbol; otherwise it is left for the caller.
+ */
+
+static void out_write(PDF417_CTX *ctx, const char *buf, size_t len) {
+    if (out_grow(ctx, len) < 0) return;
+    memcpy(ctx->out + ctx->outlen, buf, len);
+    ctx->outlen += len;
+}
+
+
+static void out_putc(PDF417_CTX *ctx, int c) {
+    if (ctx->outlen == ctx->outsize && out_grow(ctx, 1) < 0) return;
+    ctx->out[ctx->outlen++] = c;
+}
+
+
+static void out_puts(PDF417_CTX *ctx, const char *str) {
+    out_write(ctx, str, strlen(str));
+}
 
-/*-----------------------------------------------------------------*/
 
-/* Return -1 if wrong cluster */
+/* output len bytes as pairs of hex digits */
 
-static int bestham(int word, int which) {
-    int i, best = which;
+static void out_hex(PDF417_CTX *ctx, const unsigned char *b, int len) {
+    static const char hexdigits[] = "0123456789ABCDEF";
+    int j;
+
+    if (out_grow(ctx, 2 * len) < 0) return;
+    for (j = 0; j < len; ++j) {
+	ctx->out[ctx->outlen++] = hexdigits[b[j] >> 4];
+	ctx->out[ctx->outlen++] = hexdigits[b[j] & 0xf];
+    }
+}
+
+
+static void out_printf(PDF417_CTX *ctx, const char *fmt, ...) {
+    va_list ap;
+    size_t avail;
+    int n;
+
+    for (;;) {
+	avail = ctx->outsize - ctx->outlen;
+	va_start(ap, fmt);
+	n = vsnprintf(ctx->out ? ctx->out + ctx->outlen : NULL, avail, fmt, ap);
+	va_end(ap);
+	if (n < 0) return;
+	if ((size_t) n < avail) {
+	    ctx->outlen += n;
+	    return;
+	}
+	if (out_grow(ctx, n + 1) < 0) return;
+    }
+}
+
+
+/* Hand the contents of the output buffer to the output sink */
+
+int pdf417_flush(PDF417_CTX *ctx) {
+    if (ctx->sink == NULL || ctx->outlen == 0) return PDF417_OK;
+
+    if (ctx->sink(ctx->sink_arg, ctx->out, ctx->outlen) < 0) ctx->ioerr = 1;
+    ctx->outlen = 0;
+
+    return ctx->ioerr ? PDF417_ERR_WRITE : PDF417_OK;
+}
+
+
+/*
+ *  Look up a pattern in the given cluster. Returns -1 if it is nearer to
+ *  a codeword of another cluster, else the codeword with its distance in
+ *  the top byte and the cluster in the next one (3 for the start and stop
+ *  patterns), or 0xffffffff if no codeword is near enough.
+ */
+
+static int bestham(PDF417_CTX *ctx, int word, int which) {
+    UInt32 w = DHAM_CODE(DHAM_GET(word, which), which);
+#ifndef DHAM_NEAREST
+    int i;
+#endif
 
-    if (dump) printf("%d %.4x 0x%08x (%d)\n",
-                     which, word, dham[which][word], dham[which][word] & 0xffff);
+    if (ctx->dump) out_printf(ctx, "%d %.4x 0x%08x (%d)\n", which, word, w, w & 0xffff);
 
+#ifdef DHAM_NEAREST
+    if (!DHAM_NEAREST(word, which)) return -1;
+#else
     for (i = 0; i < 3; ++i) {
-	if ((dham[i][word] & 0xff000000) < (dham[best][word] & 0xff000000)) {
-	    best = i;
+	if ((DHAM_CODE(DHAM_GET(word, i), i) >> 24) < (w >> 24)) return -1;
+    }
+#endif
+
+    return w;
+}
+
+
+/*
+ *  Look up a codeword by its edge to similar edge distances (see
+ *  edge_key()). Returns the same as bestham() with a distance of 0, or
+ *  -2 if there is no codeword with these distances.
+ */
+
+static int edgeham(PDF417_CTX *ctx, UInt32 key, int which) {
+    UInt32 h, e = DEDGE_NONE;
+    int n, cluster, w;
+
+    if (key == EDGE_NOKEY) return -2;
+
+    h = DEDGE_HASH(key);
+    for (n = 0; n < DEDGE_PROBE; ++n) {
+	e = dedge[h];
+	if (e == DEDGE_NONE || (e >> 12) == key) break;
+	h = (h + 1) & ((1 << DEDGE_BITS) - 1);
+    }
+    if (e == DEDGE_NONE || (e >> 12) != key) return -2;
+
+    cluster = (e >> 10) & 3;
+    w = (cluster << 16) | (e & 0x3ff);
+
+    if (ctx->dump) out_printf(ctx, "%d t%.5x 0x%08x (%d)\n", which, key, w, w & 0xffff);
+
+    if (cluster != 3 && cluster != which) return -1;
+
+    return w;
+}
+
+
+/*
+ *  Soft decisions: how much nearer the pattern read is to the codeword
+ *  chosen than to any other codeword of its cluster.
+ */
+
+static int confidence(UInt32 read, int cw) {
+    unsigned char dist[929];
+    int c, d = 0xff;
+
+    cw_distances(read & 0x7fff, read >> 16, dist);
+    for (c = 0; c < 929; ++c) {
+	if (c != cw && dist[c] < d) d = dist[c];
+    }
+    d -= dist[cw];
+
+    return (d < 0) ? 0 : (d > PDF417_CONF_MAX) ? PDF417_CONF_MAX : d;
+}
+
+
+/*
+ *  Get the k best candidates for the codeword at position pos, nearest
+ *  first (and the lowest codeword first on ties). Returns how many were
+ *  stored in cand[].
+ */
+
+int pdf417_candidates(const PDF417_CTX *ctx, int pos, PDF417_CAND *cand, int k) {
+    unsigned char dist[929];
+    int c, i, n = 0;
+
+    if (pos < 0 || pos >= ctx->numouts || k <= 0) return PDF417_ERR_ARGS;
+
+    cw_distances(ctx->cwread[pos] & 0x7fff, ctx->cwread[pos] >> 16, dist);
+    for (c = 0; c < 929; ++c) {
+	if (n == k && dist[c] >= cand[k-1].dist) continue;
+
+	/* insert it, keeping the list sorted */
+	i = (n < k) ? n++ : k - 1;
+	while (i > 0 && cand[i-1].dist > dist[c]) {
+	    cand[i] = cand[i-1];
+	    --i;
 	}
+	cand[i].codeword = c;
+	cand[i].dist = dist[c];
     }
-    if (best != which) return -1;
+    return n;
+}
+
+
+static const PDF417_VOTE *cell_winner(const PDF417_CELL *cell, int *lead);
+
+
+/*
+ *  A cell vote has changed: update its value, and the syndromes if the
+ *  cell is in the symbol (see track_syndromes()).
+ */
 
-    return dham[which][word];
+static void cell_update(PDF417_CTX *ctx, int row, int col) {
+    PDF417_CELL *cell = &ctx->cell[row * MAX_COLS + col];
+    const PDF417_VOTE *win;
+    int lead, value;
+
+    win = cell_winner(cell, &lead);
+    value = (win != NULL) ? win->codeword : 0;
+    if (value == cell->value) return;
+
+    if (ctx->numsynd > 0 && row < ctx->nrows && col < ctx->ncols)
+	rs_syndromes_add(ctx->synd, ctx->numsynd, ctx->nrows * ctx->ncols,
+	                 row * ctx->ncols + col, value - cell->value);
+    cell->value = value;
 }
 
 
-static void add_codeword(int word) {
-    /*static int len = 0;*/
-    static int sorow = 0;  /* start of row */
-    static int skip = 0;
+/*
+ *  Add the vote of a scanline for a cell of the symbol matrix (see
+ *  PDF417_CELL). word is as returned by bestham(), and read is the
+ *  pattern it was read from, with its cluster. When all the slots are
+ *  taken, the vote replaces the lightest one if it weighs more.
+ */
+
+static void place_codeword(PDF417_CTX *ctx, int row, int col, int word, UInt32 read) {
+    PDF417_CELL *cell = &ctx->cell[row * MAX_COLS + col];
+    PDF417_VOTE *v, *min = NULL;
+    int i, cw, dist, weight;
+
+    cell->seen = 1;
 
-    if (skip) {
-	--skip;
+    /* not read, or read as a start or stop pattern */
+    if (word == -1 || ((word >> 16) & 0xff) != (read >> 16)) {
+	cell->read = read;
 	return;
     }
 
-    /*if (numouts == 0) {
-	len = word;  // not really used, but stored as codewords[0]
-    }*/
+    cw = word & 0xffff;
+    dist = (word >> 24) & 0xff;
+    weight = (dist < 3) ? 8 >> dist : 1;
 
-    if ((word & 0xffffff) == 0x030000) {  /* start sequence */
-    //if ((word & 0xff00000) == 0x2000000) {  /* start sequence */
-	skip = 1;
-	sorow = numouts;
-	return;
+    for (i = 0; i < PDF417_VOTES; ++i) {
+	v = &cell->vote[i];
+	if (v->weight == 0 || v->codeword == cw) break;
+	if (min == NULL || v->weight < min->weight) min = v;
+    }
+    if (i == PDF417_VOTES) {
+	if (weight <= min->weight) return;
+	v = min;
+	v->weight = 0;
+    }
+
+    if (v->weight == 0 || dist < v->dist) {
+	v->read = read;
+	v->dist = dist;
+    }
+    v->codeword = cw;
+    if (v->weight <= 0xffff - weight) v->weight += weight;
+
+    cell_update(ctx, row, col);
+}
+
+
+/*
+ *  The winner of a cell vote: the codeword with most weight, the nearest
+ *  read on ties, or NULL if there were no votes. lead is set to how much
+ *  more weight it has than the runner-up, or -1 if it had no rivals.
+ */
+
+static const PDF417_VOTE *cell_winner(const PDF417_CELL *cell, int *lead) {
+    const PDF417_VOTE *v, *best = NULL;
+    int i, second = -1;
+
+    for (i = 0; i < PDF417_VOTES; ++i) {
+	v = &cell->vote[i];
+	if (v->weight == 0) continue;
+	if (best == NULL || v->weight > best->weight ||
+	    (v->weight == best->weight && v->dist < best->dist)) {
+	    if (best != NULL && best->weight > second) second = best->weight;
+	    best = v;
+	} else if (v->weight > second) {
+	    second = v->weight;
+	}
+    }
+
+    *lead = (best != NULL && second >= 0) ? best->weight - second : -1;
+    return best;
+}
+
+
+/* the row number given by a row indicator, or -1 if it was not read */
+
+static int ri_row(int word, int cluster) {
+    if (word == -1 || ((word >> 16) & 0xff) != cluster) return -1;
+    if ((word & 0xffff) >= 900) return -1;
+    return 3 * ((word & 0xffff) / 30) + cluster;
+}
+
+
+/*
+ *  The row indicators hold, besides the row number, one of three values
+ *  of the symbol layout, depending on the row cluster and the side:
+ *
+ *    cluster   left                        right
+ *       0      (rows - 1) / 3              cols - 1
+ *       1      ecl * 3 + (rows - 1) % 3    (rows - 1) / 3
+ *       2      cols - 1                    ecl * 3 + (rows - 1) % 3
+ *
+ *  so the value is (cluster + 2 * right) % 3 in the order above. Every
+ *  indicator read counts as a vote for its value.
+ */
+
+static void ri_vote(PDF417_CTX *ctx, int word, int cluster, int right) {
+    if (ri_row(word, cluster) < 0) return;
+    ++ctx->rivotes[(cluster + 2 * right) % 3][(word & 0xffff) % 30];
+}
+
+
+/*
+ *  Place the codewords of a row in the symbol matrix. The start and stop
+ *  patterns give the columns, and the row indicators next to them the
+ *  row; if neither indicator can be read, the row is taken to follow
+ *  the last one placed, as far as its cluster tells. Every scanline of
+ *  a row, and the same row read again from another band, votes on the
+ *  same cells.
+ */
+
+static void add_row(PDF417_CTX *ctx, const int *cw, const UInt32 *words, int n, int cluster) {
+    int i, start = -1, stop = -1, left = -1, right = -1;
+    int row, rrow, col, first, last;
+
+    for (i = 0; i < n; ++i) {
+	if (cw[i] == -1 || ((cw[i] >> 16) & 0xff) != 3) continue;
+	if ((cw[i] & 0xffff) == 0 && start < 0 && stop < 0) start = i;
+	else if ((cw[i] & 0xffff) == 1 && stop < 0) stop = i;
     }
+    if (start >= 0 && start + 1 < n && start + 1 != stop) left = cw[start + 1];
+    if (stop > 0 && stop - 1 > start + 1) right = cw[stop - 1];
+
+    ri_vote(ctx, left, cluster, 0);
+    ri_vote(ctx, right, cluster, 1);
+
+    /* the nearer of the two indicators, the left one on ties */
+    row = ri_row(left, cluster);
+    rrow = ri_row(right, cluster);
+    if (rrow >= 0 && (row < 0 || (right >> 24) < (left >> 24))) row = rrow;
 
-    if ((word & 0xffffff) == 0x030001) {  /* stop sequence? */
-	--numouts;
+    if (row < 0) {
+	if (ctx->lastrow < 0) return;
+	row = ctx->lastrow + (cluster - ctx->lastrow % 3 + 3) % 3;
+    }
+    if (row >= MAX_ROWS) {
+	ctx->overflow = 1;
+	return;
+    }
+    ctx->lastrow = row;
+
+    /* the data columns lie between the row indicators */
+    if (start >= 0) {
+	first = start + 2;
+	last = (stop >= 0) ? stop - 2 : n - 1;
+	col = 0;
+    } else if (stop >= 0 && ctx->ncols > 0) {
+	last = stop - 2;
+	first = last - ctx->ncols + 1;
+	col = 0;
+	if (first < 0) {
+	    col = -first;
+	    first = 0;
+	}
+    } else {
 	return;
     }
 
-    if (word == -3) {
-	/* Rewind to beginning of row */
-	numouts = sorow;
+    for (i = first; i <= last && col < MAX_COLS; ++i, ++col) {
+	place_codeword(ctx, row, col, cw[i], ((UInt32) cluster << 16) | words[i]);
+    }
+}
+
+
+/* the value with most votes, or -1 if there are none */
+
+static int ri_value(const int *votes) {
+    int i, best = -1;
+
+    for (i = 0; i < 30; ++i) {
+	if (votes[i] > 0 && (best < 0 || votes[i] > votes[best])) best = i;
+    }
+    return best;
+}
+
+
+/*
+ *  The symbol size and error correction level voted by the row
+ *  indicators, 0 (or -1 for the level) where there are no votes.
+ *  Returns whether all three are known.
+ */
+
+static int ri_layout(const PDF417_CTX *ctx, int *rows, int *cols, int *ecl) {
+    int hi = ri_value(ctx->rivotes[0]);
+    int lo = ri_value(ctx->rivotes[1]);
+    int c = ri_value(ctx->rivotes[2]);
+
+    *rows = (hi >= 0 && lo >= 0 && 3 * hi + lo % 3 + 1 >= 3) ? 3 * hi + lo % 3 + 1 : 0;
+    *cols = (c >= 0) ? c + 1 : 0;
+    *ecl = (lo >= 0) ? lo / 3 : -1;
+
+    return *rows > 0 && *cols > 0 && *ecl >= 0;
+}
+
+
+/*
+ *  Start keeping the syndromes of the cell values once the size of the
+ *  symbol is known, and start over if the row indicator votes change it.
+ */
+
+static void track_syndromes(PDF417_CTX *ctx) {
+    int *data;
+    int rows, cols, ecl, r, c;
+
+    if (!ri_layout(ctx, &rows, &cols, &ecl)) return;
+    if (ctx->numsynd > 0 && rows == ctx->nrows && cols == ctx->ncols && ecl == ctx->ecl)
 	return;
+
+    ctx->nrows = rows;
+    ctx->ncols = cols;
+    ctx->ecl = ecl;
+    ctx->numsynd = 0;
+    if (rows * cols > 928 || (2 << ecl) >= rows * cols) return;
+    if ((data = ctx_scratch(ctx)) == NULL) return;
+
+    ctx->numsynd = 2 << ecl;
+    for (r = 0; r < rows; ++r) {
+	for (c = 0; c < cols; ++c)
+	    data[r * cols + c] = ctx->cell[r * MAX_COLS + c].value;
     }
+    rs_syndromes(data, rows * cols, ctx->numsynd, ctx->synd);
+}
+
+
+/*
+ *  Whether the symbol can be decoded from what has been read so far, so
+ *  that the rest of the image need not be scanned: its size and error
+ *  correction level are known, and a trial Reed-Solomon decoding, with
+ *  the cells not read yet as erasures, succeeds with ctx->margin check
+ *  codewords to spare, i.e. it could still correct that many misread
+ *  codewords (erasures + 2 (errors + margin) <= ECC codewords). Without
+ *  error correction, and in soft mode (whose erasures are only known at
+ *  the end), every cell must have been read first, and without error
+ *  correction there must be no errors either.
+ */
+
+static int symbol_done(PDF417_CTX *ctx) {
+    const PDF417_CELL *cell;
+    RS_WORK *work;
+    int *cw, *eras;
+    int n, nsynd = ctx->numsynd, i, f, num;
+
+    if (nsynd == 0 || (cw = ctx_scratch(ctx)) == NULL) return 0;
+    eras = cw + MAX_CODEWORDS;
+
+    n = ctx->nrows * ctx->ncols;
+    for (i = f = 0; i < n; ++i) {
+	cell = &ctx->cell[(i / ctx->ncols) * MAX_COLS + i % ctx->ncols];
+	cw[i] = cell->value;
+	if (cell->vote[0].weight == 0) {
+	    if (!ctx->ecc || ctx->soft || f + 1 + 2 * ctx->margin > nsynd) return 0;
+	    eras[f++] = i;
+	}
+    }
+
+    /* all read, and a codeword already */
+    if (f == 0) {
+	for (i = 1; i <= nsynd && ctx->synd[i] == 0; ++i) ;
+	if (i > nsynd) return 1;
+	if (!ctx->ecc) return 0;
+    }
+
+    if ((work = ctx_rswork(ctx)) == NULL) return 0;
+    num = eras_dec_rs_synd(work, cw, ctx->synd, eras, f, n, nsynd);
+    if (num < 0) return 0;
+
+    return f + 2 * (num - f + ctx->margin) <= nsynd;
+}
+
+
+/*
+ *  Work out the symbol size from the row indicators, and lay out the
+ *  winners of the cell votes in codewords[], row by row. The cells
+ *  without votes are erasures. Without indicator votes the size is that
+ *  of the cells read.
+ */
+
+static void build_symbol(PDF417_CTX *ctx) {
+    int rows, cols, ecl, seenrows;
+    int r, c, i, lead, conf;
+
+    /* the syndromes kept are only good for the same layout */
+    if (!ri_layout(ctx, &rows, &cols, &ecl) ||
+	rows != ctx->nrows || cols != ctx->ncols || ecl != ctx->ecl)
+	ctx->numsynd = 0;
 
-    if ((word & 0xffff) == 0xffff) {
-	word = 0;
-	erasures[numerasures++] = numouts;
+    ctx->nrows = ctx->ncols = 0;
+
+    for (i = 0; i < MAX_ROWS * MAX_COLS; ++i) {
+	if (!ctx->cell[i].seen) continue;
+	if (i / MAX_COLS >= ctx->nrows) ctx->nrows = i / MAX_COLS + 1;
+	if (i % MAX_COLS >= ctx->ncols) ctx->ncols = i % MAX_COLS + 1;
     }
+    ctx->ecl = ecl;
+    if (ctx->nrows == 0) return;
+
+    /* an early stop leaves the rows past the last one seen unread */
+    seenrows = ctx->nrows;
+    if (rows > 0) ctx->nrows = rows;
+    if (cols > 0) ctx->ncols = cols;
+
+    ctx->numouts = ctx->nrows * ctx->ncols;
+    ctx->numerasures = 0;
+    ctx->numunread = 0;
+
+    for (r = 0; r < ctx->nrows; ++r) {
+	for (c = 0; c < ctx->ncols; ++c) {
+	    const PDF417_CELL *cell = &ctx->cell[r * MAX_COLS + c];
+	    const PDF417_VOTE *win = cell_winner(cell, &lead);
+
+	    i = r * ctx->ncols + c;
+	    if (win == NULL) {
+		ctx->codewords[i] = 0;
+		ctx->cwread[i] = cell->read;
+		ctx->confidence[i] = 0;
+		ctx->erasures[ctx->numerasures++] = i;
+		if (ctx->done && r >= seenrows) ++ctx->numunread;
+		continue;
+	    }
 
-    /* store codeword */
-    codewords[numouts++] = word & 0xffff;
+	    ctx->codewords[i] = win->codeword;
+	    ctx->cwread[i] = win->read;
+	    ctx->confidence[i] = 0;
+	    if (!ctx->soft) continue;
+
+	    /*
+	     *  In soft mode, codewords too close to call are erased as well.
+	     *  A contested vote is no surer than its lead, a quarter of which
+	     *  counts as a module: a tie gives 0, and a lead of one exact
+	     *  read 2.
+	     */
+	    conf = confidence(win->read, win->codeword);
+	    if (lead >= 0 && lead / 4 < conf) conf = lead / 4;
+	    ctx->confidence[i] = conf;
+	    if (conf < ctx->soft) ctx->erasures[ctx->numerasures++] = i;
+	}
+    }
 }
 
 
@@ -151,14 +722,15 @@ static void add_codeword(int word) {
  *  human readable format.
  */
 
-static void decode_codewords() {
+static void decode_codewords(PDF417_CTX *ctx) {
     int   i, cw, len, slen, mode, shift;
-    Int32 segment[34*90];  /* single compaction segment to be decoded */
+    Int32 *segment;  /* single compaction segment to be decoded */
 
-    if (numouts == 0) return;
+    if (ctx->numouts == 0 || (segment = ctx_scratch(ctx)) == NULL) return;
 
-    len = codewords[0];
-    if (len == 0) return;
+    /* a length descriptor past the symbol was misread */
+    len = ctx->codewords[0];
+    if (len <= 0 || len > ctx->numouts) return;
 
     slen = 0;
 
@@ -166,10 +738,10 @@ static void decode_codewords() {
     shift = mode;
 
     for (i = 1; i < len; ++i) {
-        cw = codewords[i];
+        cw = ctx->codewords[i];
         if (cw >= 900) {
 
-            if (slen > 0) decode_segment(segment, slen, mode);
+            if (slen > 0) decode_segment(ctx, segment, slen, mode);
             slen = 0;
 
             switch (cw) {
@@ -207,7 +779,7 @@ static void decode_codewords() {
                 break;
 
             default:
-                fprintf(stderr, "Unknown mode %d\n", cw);
+                if (ctx->debug) out_printf(ctx, "Unknown mode %d\n", cw);
                 break;
             }
             continue;
@@ -216,44 +788,44 @@ static void decode_codewords() {
 	segment[slen++] = cw;
 
 	if (shift != mode) {
-	    if (slen > 0) decode_segment(segment, slen, shift);
+	    if (slen > 0) decode_segment(ctx, segment, slen, shift);
 	    slen = 0;
 	    shift = mode;
 	}
     }
 
-    if (slen > 0) decode_segment(segment, slen, mode);
+    if (slen > 0) decode_segment(ctx, segment, slen, mode);
 }
 
 
-void decode_segment(int *cw, int len, int mode) {
+static void decode_segment(PDF417_CTX *ctx, int *cw, int len, int mode) {
 
     switch (mode) {
     case 900:
-	convert_text(cw, len);
+	convert_text(ctx, cw, len);
 	break;
 
     case 901:
     case 913:
     case 924:
-        convert_byte(cw, len, mode);
+        convert_byte(ctx, cw, len, mode);
     	break;
 
     case 902:
-        convert_num(cw, len);
+        convert_num(ctx, cw, len);
     	break;
     }
 }
 
 
-void convert_byte(int *cw, int len, int mode) {
+static void convert_byte(PDF417_CTX *ctx, int *cw, int len, int mode) {
     UInt64 codeval;
     int i, j;
     unsigned char b[6];
 
-    if (debug > 1) printf("convert_byte: %d codewords (mode = %d)\n", len, mode);
+    if (ctx->debug > 1) out_printf(ctx, "convert_byte: %d codewords (mode = %d)\n", len, mode);
 
-    if (encfmt) printf("BC \"");
+    if (ctx->encfmt) out_puts(ctx, "BC \"");
 
     /* 6 bytes are encoded in a group of 5 codewords */
     for ( ; (mode == 901) ? (len > 5) : (len >= 5); len -= 5) {
@@ -266,61 +838,59 @@ void convert_byte(int *cw, int len, int mode) {
 	    codeval += *cw++;
 	}
 
-	if (debug > 1) printf("codeval = %Lx, giving ", codeval);
+	if (ctx->debug > 1) out_printf(ctx, "codeval = %Lx, giving ", codeval);
 
 	for (j = 0; j < 6; ++j) {
 	    b[5-j] = codeval % 256;
-	    if (debug > 1) printf("[%02x] ", b[5-j]);
+	    if (ctx->debug > 1) out_printf(ctx, "[%02x] ", b[5-j]);
 	    codeval >>= 8;
 	}
-	if (debug > 1) printf("\n");
+	if (ctx->debug > 1) out_printf(ctx, "\n");
 
-	if (encfmt) {
-	    for (j = 0; j < 6; ++j) printf("%02X", b[j]);
+	if (ctx->encfmt) {
+	    out_hex(ctx, b, 6);
 	} else {
-	    for (j = 0; j < 6; ++j) printf("%c", b[j]);
+	    out_write(ctx, (char *) b, 6);
 	}
     }
 
     /* remaining codewords, if any, are encoded 1 byte per codeword */
     if (len > 0) {
-	if (debug > 1) printf("remaining %d codewords: ", len);
+	if (ctx->debug > 1) out_printf(ctx, "remaining %d codewords: ", len);
 	for (j = 0; j < len; ++j) {
 	    b[j] = *cw++;
-	    if (debug > 1) printf("[%02x] ", b[j]);
+	    if (ctx->debug > 1) out_printf(ctx, "[%02x] ", b[j]);
         }
-	if (debug > 1) printf("\n");
+	if (ctx->debug > 1) out_printf(ctx, "\n");
 
-	if (encfmt) {
-	    for (j = 0; j < len; ++j) printf("%02X", b[j]);
+	if (ctx->encfmt) {
+	    out_hex(ctx, b, len);
 	} else {
-	    for (j = 0; j < len; ++j) printf("%c", b[j]);
+	    out_write(ctx, (char *) b, len);
 	}
 
 	codeval = 0;
 	i = 0;
     }
 
-    if (encfmt) printf("\"\n");
-
-    fflush(stdout);
+    if (ctx->encfmt) out_puts(ctx, "\"\n");
 }
 
 
-void convert_text(int *cw, int len) {
+static void convert_text(PDF417_CTX *ctx, int *cw, int len) {
     int mode, shift, enc;
     int i, j, c[2], cout;
 
-    static char txt_upper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ    ";
-    static char txt_lower[] = "abcdefghijklmnopqrstuvwxyz    ";
-    static char txt_mixed[] = "0123456789&\r\t,:#-.$/+%*=^     ";
-    static char txt_punct[] = ";<>@[\\]_`~!\r\t,:\n-.$/\"|*()?{}' ";
+    static const char txt_upper[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ    ";
+    static const char txt_lower[] = "abcdefghijklmnopqrstuvwxyz    ";
+    static const char txt_mixed[] = "0123456789&\r\t,:#-.$/+%*=^     ";
+    static const char txt_punct[] = ";<>@[\\]_`~!\r\t,:\n-.$/\"|*()?{}' ";
 
-    if (debug > 1) printf("convert_text: %d codewords\n", len);
+    if (ctx->debug > 1) out_printf(ctx, "convert_text: %d codewords\n", len);
 
     mode = shift = 0;
 
-    if (encfmt) printf("TC \"");
+    if (ctx->encfmt) out_puts(ctx, "TC \"");
 
     for (i = 0; i < len; ++i) {
 
@@ -330,7 +900,7 @@ void convert_text(int *cw, int len) {
 
 	for (j = 0; j < 2; ++j) {
 
-	    if (debug > 1) printf(" (%d)-", c[j]);
+	    if (ctx->debug > 1) out_printf(ctx, " (%d)-", c[j]);
 
 	    enc = mode;
             if (mode != shift) { enc = shift; shift = mode; }
@@ -362,15 +932,17 @@ void convert_text(int *cw, int len) {
 	        if (c[j] == 29) { mode = shift = 0; continue; }  /* upper latch */
 	        cout = txt_punct[c[j]];
 	        break;
+
+	    default:
+	        continue;
 	    }
 
-	    printf("%c", cout);
+	    out_putc(ctx, cout);
         }
 
     }
 
-    if (encfmt) printf("\"\n");
-    fflush(stdout);
+    if (ctx->encfmt) out_puts(ctx, "\"\n");
 }
 
 
@@ -383,11 +955,11 @@ void convert_text(int *cw, int len) {
  *  large-precision number manipulations.
  */
 
-void convert_num(int *cw, int len) {
+static void convert_num(PDF417_CTX *ctx, int *cw, int len) {
     int n_bcd[45], cw_bcd[3];
     int i, j, n, res, carry, start;
 
-    if (debug > 1) printf("convert_num: %d codewords\n", len);
+    if (ctx->debug > 1) out_printf(ctx, "convert_num: %d codewords\n", len);
 
     for ( ; len > 0; len -= 15) {
 
@@ -441,34 +1013,90 @@ void convert_num(int *cw, int len) {
 
         start = 0;
 
-        if (encfmt) printf("NC \"");
+        if (ctx->encfmt) out_puts(ctx, "NC \"");
         for (j = 0; j < 45; ++j) {
             if (start) {
-                printf("%c", n_bcd[44-j] + '0');
+                out_putc(ctx, n_bcd[44-j] + '0');
             } else if (n_bcd[44-j] == 1) {
                 start = 1;
             } else if (n_bcd[44-j] != 0) {
-                printf("<invalid>");
+                out_puts(ctx, "<invalid>");
                 break;
             }
         }
-        if (encfmt) printf("\"\n");
+        if (ctx->encfmt) out_puts(ctx, "\"\n");
+    }
+
+}
+
+
+/*
+ *  Which cluster a codeword belongs to. With b1 to b4 the widths of its
+ *  bars, (b1 - b2 + b3 - b4) mod 9 is 0, 3 or 6 for clusters 0, 1 and 2,
+ *  and b1 - b2 = t1 - t2, b3 - b4 = t5 - t6 in terms of the edge
+ *  distances, which bar growth does not change. If these cannot be
+ *  measured, the cluster with the nearest codeword is used. Returns -1
+ *  if it cannot tell, and for the start and stop patterns.
+ */
+
+static int cw_cluster(UInt32 word, UInt32 key) {
+    int i, k, d, best = -1, bestd = 0x100;
+    UInt32 w;
+
+    if (key != EDGE_NOKEY) {
+	if (key == DEDGE_START || key == DEDGE_STOP) return -1;
+	k = ((key >> 15) & 7) - ((key >> 12) & 7) + ((key >> 3) & 7) - (key & 7);
+	k = (k + 18) % 9;
+	return (k % 3 == 0) ? k / 3 : -1;
+    }
+
+    for (i = 0; i < 3; ++i) {
+	w = DHAM_CODE(DHAM_GET(word, i), i);
+	if (w == 0xffffffff || ((w >> 16) & 0xff) == 3) continue;
+	d = w >> 24;
+	if (d < bestd) {
+	    best = i;
+	    bestd = d;
+	} else if (d == bestd) {
+	    best = -1;
+	}
     }
+    return best;
+}
 
+
+/*
+ *  The cluster of a row: the one most of its codewords belong to. On a
+ *  tie, or if none can be told, the one expected after the previous rows.
+ */
+
+static int row_cluster(const UInt32 *words, const UInt32 *keys, int ncw, int rownum) {
+    int votes[3] = { 0, 0, 0 };
+    int i, c, best = rownum % 3;
+
+    for (i = 0; i < ncw; ++i) {
+	c = cw_cluster(words[i], keys[i]);
+	if (c >= 0) ++votes[c];
+    }
+    for (c = 0; c < 3; ++c) {
+	if (votes[c] > votes[best]) best = c;
+    }
+    return best;
 }
 
 
 /* this routine extracts the codewords from a single pixel row from the image */
 
-int processrow(int cols, int rownum, int num, double *cumbits) {
+static int processrow(PDF417_CTX *ctx, int cols, int rownum, int num, const int *cumbits) {
     int firstblack = 0;
-    int scale;
     int j;
-    int nchange;
-    int cumchange[cols];
-    double thresh = 0.5 * num;
+    int nchange, ncw;
+    int *cumchange = ctx->changes;
+
+    /* a column is white if less than half of the band pixels are black */
+#define WHITE(j)  (2 * cumbits[j] < num)
 
-    while ((firstblack < cols) && (cumbits[firstblack] < thresh))
+    while ((firstblack < cols) && WHITE(firstblack))
 	++firstblack;
 
     if (firstblack+1 >= cols) return 0;
@@ -476,7 +1104,7 @@ int processrow(int cols, int rownum, int num, double *cumbits) {
     cumchange[nchange++] = 0;
 
     for (j = firstblack+1; j < cols; ++j) {
-	if ((cumbits[j] < thresh) != (cumbits[j-1] < thresh)) {
+	if (WHITE(j) != WHITE(j-1)) {
 	    if (nchange > 1 &&
 		(j - firstblack - cumchange[nchange-1]) * 15 < cumchange[1]) {
 		/* Spurious change */
@@ -487,127 +1115,382 @@ int processrow(int cols, int rownum, int num, double *cumbits) {
 	}
     }
 
-    if (debug > 1) {
+    if (ctx->debug > 1) {
         for (j = 0; j < nchange; ++j) {
-	    printf("%3d ", cumchange[j]);
+	    out_printf(ctx, "%3d ", cumchange[j]);
         }
-        printf("\n");
+        out_printf(ctx, "\n");
     }
 
     if (nchange < 8) return 0;
 
-    for (j = 0; j < nchange-8; j += 8) {
-	int k;
-	int word = 0;
-	unsigned cw;
-
-	scale = cumchange[j+8] - cumchange[j];
-	for (k = 0; k < 8; k += 2) {
-	    int s, e, l;
-
-	    s = (int) (17.0 * (double) (cumchange[j+k] - cumchange[j]) / (double) scale + 0.5);
-	    e = (int) (17.0 * (double) (cumchange[j+k+1] - cumchange[j]) / (double) scale + 0.5);
-	    /* We know we always start with 1, end with 0 */
-	    if (s < 1) s = 1;
-	    if (e > 16) e = 16;
-	    for (l = s; l < e; ++l) word |= mask[l-1];
+    /* one codeword for every 8 edges, the last one ending the row */
+    ncw = (nchange - 1) / 8;
+    if (ncw > 0) {
+	UInt32 *words = ctx->words, *keys = ctx->words + ncw;
+	int *cws = ctx->cws;
+	int cluster;
+
+	quantize_row(cumchange, ncw, words);
+	for (j = 0; j < ncw; ++j) keys[j] = edge_key(cumchange + 8 * j);
+
+	cluster = row_cluster(words, keys, ncw, rownum);
+
+	for (j = 0; j < ncw; ++j) {
+	    int cw = bestham(ctx, words[j], cluster);
+
+	    if (ctx->edges && (cw == -1 || (cw >> 24) != 0)) {
+		int ecw = edgeham(ctx, keys[j], cluster);
+
+		if (ecw >= 0) cw = ecw;
+	    }
+	    cws[j] = cw;
 	}
-	word >>= 1;
-	cw = bestham(word, rownum % 3);
-	add_codeword(cw);
+	add_row(ctx, cws, words, ncw, cluster);
     }
 
     return 1;
 }
 
 
-int main(int argc, char **argv) {
-    FILE *pf;
-    int rows, cols;
-    bit **bits;
-    double *cumbits;
-    int i, j;
-    int ready, num, ecc = 0;
-    int rownum;
-    char *myname = argv[0];
-
-    for (i = 0; i < 15; ++i) mask[i] = 1 << (15-i);
-
-    for ( ; argc > 1; --argc, ++argv) {
-        if (strcmp(argv[1], "-d") == 0)
-            ++debug;
-        else if (strcmp(argv[1], "-c") == 0)
-            dump = 1;
-        else if (strcmp(argv[1], "-e") == 0)
-            encfmt = 1;
-        else if (strcmp(argv[1], "-rs") == 0)
-            ecc = 1;
-        else
-            break;
-    }
-    pbm_init(&argc, argv);
-
-    if (argc > 1) {
-      pf = fopen(argv[1], "r");
-    } else {
-      fprintf(stderr, "usage: %s [-d] [-c] [-e] [-rs] file\n", myname);
-      exit(1);
+/*
+ *  Row at a time scanning. pdf417_scan_begin() prepares the context for
+ *  an image cols pixels wide, clearing what it holds of the previous
+ *  image (see pdf417_reset()), then every packed row is passed in turn,
+ *  top to bottom, to pdf417_scan_row(), and pdf417_scan_end() finishes
+ *  the scan. Only the previous row and the band accumulator are needed,
+ *  so memory use does not depend on the image height. The previous row
+ *  is not copied: each row buffer must stay valid until the next call.
+ */
+
+int pdf417_scan_begin(PDF417_CTX *ctx, int cols) {
+    size_t nwords;
+
+    if (cols <= 0 || cols > PDF417_MAX_WIDTH) return PDF417_ERR_ARGS;
+    nwords = ((size_t) cols + 63) / 64;
+
+    pdf417_reset(ctx);
+
+    if (cols > ctx->cumsize) {
+	UInt64 *planes = realloc(ctx->planes, 2 * nwords * NPLANES * sizeof(UInt64));
+	int *counts, *changes, *cws;
+	UInt32 *words;
+
+	if (planes == NULL) return PDF417_ERR_NOMEM;
+	ctx->planes = planes;
+
+	counts = realloc(ctx->counts, 3 * nwords * 64 * sizeof(int));
+	if (counts == NULL) return PDF417_ERR_NOMEM;
+	ctx->counts = counts;
+
+	/* a row has at most one edge per column, and 8 per codeword */
+	changes = realloc(ctx->changes, nwords * 64 * sizeof(int));
+	if (changes == NULL) return PDF417_ERR_NOMEM;
+	ctx->changes = changes;
+
+	cws = realloc(ctx->cws, nwords * 8 * sizeof(int));
+	if (cws == NULL) return PDF417_ERR_NOMEM;
+	ctx->cws = cws;
+
+	words = realloc(ctx->words, 2 * nwords * 8 * sizeof(UInt32));
+	if (words == NULL) return PDF417_ERR_NOMEM;
+	ctx->words = words;
+
+	ctx->cumsize = (int) nwords * 64;
+    }
+
+    ctx->cols = cols;
+    ctx->prevrow = NULL;
+    ctx->ready = 1;
+    ctx->num = 0;
+    ctx->rownum = 0;
+    ctx->done = 0;
+
+    return PDF417_OK;
+}
+
+
+static int scan_status(PDF417_CTX *ctx) {
+    if (ctx->nomem) return PDF417_ERR_NOMEM;
+    if (ctx->overflow) return PDF417_ERR_OVERFLOW;
+    return PDF417_OK;
+}
+
+
+/*
+ *  The band pixels are accumulated in bit-sliced counters (see
+ *  band_add()), which are only turned into per-column counts when the
+ *  band is complete, or when they are about to overflow. The even and
+ *  odd pixel rows of the band go to separate counters.
+ */
+
+static void band_start(PDF417_CTX *ctx) {
+    int nwords = (ctx->cols + 63) / 64;
+
+    memset(ctx->planes, 0, 2 * nwords * NPLANES * sizeof(UInt64));
+    ctx->spilled = 0;
+    ctx->num = 0;
+}
+
+
+static void band_spill(PDF417_CTX *ctx) {
+    int nwords = (ctx->cols + 63) / 64;
+    int *odd = ctx->counts + ctx->cumsize;
+
+    if (!ctx->spilled) {
+	memset(ctx->counts, 0, ctx->cols * sizeof(int));
+	memset(odd, 0, ctx->cols * sizeof(int));
     }
+    band_counts(ctx->planes, ctx->counts, ctx->cols);
+    band_counts(ctx->planes + nwords * NPLANES, odd, ctx->cols);
+    memset(ctx->planes, 0, 2 * nwords * NPLANES * sizeof(UInt64));
+    ctx->spilled = 1;
+}
+
+
+/*
+ *  The whole band is read as one scanline, then its even and odd pixel
+ *  rows as two more, which vote on the same cells of the symbol matrix
+ *  (see place_codeword()). These are read quietly: the debug and dump
+ *  output is that of the whole band.
+ */
 
-    if (pf == NULL) {
-      fprintf(stderr, "%s: could not open file: %s\n", myname, argv[1]);
-      exit(1);
+static void band_end(PDF417_CTX *ctx) {
+    int *even = ctx->counts, *odd = even + ctx->cumsize, *all = odd + ctx->cumsize;
+    int j, debug = ctx->debug, dump = ctx->dump;
+
+    band_spill(ctx);
+    for (j = 0; j < ctx->cols; ++j) all[j] = even[j] + odd[j];
+
+    if (!processrow(ctx, ctx->cols, ctx->rownum, ctx->num, all)) return;
+
+    if (ctx->num >= 2) {
+	ctx->debug = ctx->dump = 0;
+	processrow(ctx, ctx->cols, ctx->rownum, (ctx->num + 1) / 2, even);
+	processrow(ctx, ctx->cols, ctx->rownum, ctx->num / 2, odd);
+	ctx->debug = debug;
+	ctx->dump = dump;
     }
+    ++ctx->rownum;
+
+    track_syndromes(ctx);
+    if (symbol_done(ctx)) ctx->done = 1;
+}
 
-    bits = pbm_readpbm(pf, &cols, &rows);
-    fclose(pf);
 
-    cumbits = malloc(cols * sizeof(double));
+/*
+ *  Returns PDF417_DONE once the symbol can be decoded without the rest
+ *  of the image (see symbol_done()); the caller can then stop reading
+ *  it, and call pdf417_scan_end() right away.
+ */
+
+int pdf417_scan_row(PDF417_CTX *ctx, const unsigned char *row) {
+    const unsigned char *prev = ctx->prevrow;
+    int cols = ctx->cols;
+    int d;
 
-    ready = 1;
-    num = 0;
-    rownum = 0;
+    if (ctx->done) return PDF417_DONE;
 
-    for (j = 0; j < cols; ++j) cumbits[j] = 0.0;
+    ctx->prevrow = row;
+    if (prev == NULL) return scan_status(ctx);
 
-    for (i = 1; i < rows; ++i) {
-	int d = 0;
-	for (j = 0; j < cols; ++j) {
-	    if (bits[i][j] != bits[i-1][j]) ++d;
+    d = row_diff(row, prev, cols, FUZZ_THRESH, ROW_THRESH);
+    if (d < FUZZ_THRESH) {
+	if (ctx->ready == 1) {
+	    band_start(ctx);
+	    ctx->ready = 2;
 	}
-	if (d < FUZZ_THRESH) {
-	    if (ready == 1) {
-		num = 0;
-		for (j = 0; j < cols; ++j) cumbits[j] = 0.0;
-		ready = 2;
-	    }
-	    for (j = 0; j < cols; ++j) {
-		if (bits[i][j] == PBM_BLACK) cumbits[j] += 1.0;
-	    }
-	    ++num;
-	} else if (d > ROW_THRESH) {
-	    if (ready == 2) {
-		if (processrow(cols, rownum, num, cumbits)) ++rownum;
-		ready = 1;
-	    }
+	band_add(ctx->planes + (ctx->num & 1) * ((cols + 63) / 64) * NPLANES, row, cols);
+	if (++ctx->num % BAND_SPILL == 0) band_spill(ctx);
+    } else if (d > ROW_THRESH) {
+	if (ctx->ready == 2) {
+	    band_end(ctx);
+	    ctx->ready = 1;
 	}
     }
-    if (ready == 2) if (processrow(cols, rownum, num, cumbits)) ++rownum;
 
-    if (ecc) {
-	printf("Total codewords = %d (%d data, %d ECC)\n",
-	       numouts, codewords[0], numouts - codewords[0]);
+    if (scan_status(ctx) < 0) return scan_status(ctx);
+    return ctx->done ? PDF417_DONE : PDF417_OK;
+}
+
+
+int pdf417_scan_end(PDF417_CTX *ctx) {
+    if (ctx->ready == 2 && !ctx->done) band_end(ctx);
+    ctx->ready = 1;
+    ctx->prevrow = NULL;
+    build_symbol(ctx);
+
+    if (scan_status(ctx) < 0) return scan_status(ctx);
+    if (ctx->numouts == 0) return PDF417_ERR_NOTFOUND;
+    return PDF417_OK;
+}
+
+
+/* Extract the codewords from a bitmap image */
+
+int pdf417_scan_image(PDF417_CTX *ctx, const PDF417_IMAGE *img) {
+    int i, err;
+
+    if (img->bits == NULL || img->rows <= 0) return PDF417_ERR_ARGS;
+
+    err = pdf417_scan_begin(ctx, img->cols);
+    if (err < 0) return err;
 
-	//num = eras_dec_rs(codewords, erasures, numerasures, numouts, numouts - codewords[0]);
-	num = eras_dec_rs(codewords, NULL, 0, numouts, numouts - codewords[0]);
-	if (num < 0)
-	    printf("Errors detected, but data could not be corrected\n");
-	else if (num > 0)
-	    printf("%d codewords corrected\n\n", num);
+    for (i = 0; i < img->rows; ++i) {
+	err = pdf417_scan_row(ctx, img->bits + (size_t) i * img->stride);
+	if (err < 0) return err;
+	if (err == PDF417_DONE) break;
     }
 
-    decode_codewords();
+    return pdf417_scan_end(ctx);
+}
 
-    pbm_freearray(bits, rows);
-    return 0;
+
+/*
+ *  Extract the codewords from an image given as a buffer of rows of
+ *  cols pixels each, one byte per pixel (non-zero for black), with
+ *  rows starting every stride bytes.
+ */
+
+int pdf417_scan(PDF417_CTX *ctx, const unsigned char *pixels,
+                int cols, int rows, int stride) {
+    PDF417_IMAGE img;
+    int err;
+
+    err = pdf417_image_pack(&img, pixels, cols, rows, stride);
+    if (err < 0) return err;
+
+    err = pdf417_scan_image(ctx, &img);
+    pdf417_image_free(&img);
+
+    return err;
+}
+
+
+static int cmp_pos(const void *a, const void *b) {
+    return *(const int *) a - *(const int *) b;
+}
+
+
+/*
+ *  Perform Reed-Solomon error detection and correction on the extracted
+ *  codewords. Returns the number of codewords corrected, not counting
+ *  the cells left unread when the scan stopped early (ctx->numunread),
+ *  which are filled in as well.
+ *
+ *  The erased codewords are passed to the decoder as erasures, which
+ *  cost half as many ECC codewords as errors at unknown positions. The
+ *  decoder needs them sorted out first: each position once, and only
+ *  positions inside the symbol.
+ */
+
+int pdf417_correct(PDF417_CTX *ctx) {
+    RS_WORK *work;
+    int *eras;
+    int ndata, num, i, n;
+
+    if (ctx->numouts == 0) return PDF417_ERR_NOTFOUND;
+    if ((eras = ctx_scratch(ctx)) == NULL) return PDF417_ERR_NOMEM;
+    if ((work = ctx_rswork(ctx)) == NULL) return PDF417_ERR_NOMEM;
+
+    /* the ECC level of the row indicators, else the length descriptor */
+    if (ctx->ecl >= 0)
+	ndata = ctx->numouts - (2 << ctx->ecl);
+    else
+	ndata = ctx->codewords[0];
+    if (ndata >= ctx->numouts) return 0;  /* no ECC codewords */
+
+    for (i = n = 0; i < ctx->numerasures; ++i) {
+	if (ctx->erasures[i] >= 0 && ctx->erasures[i] < ctx->numouts)
+	    eras[n++] = ctx->erasures[i];
+    }
+    qsort(eras, n, sizeof(int), cmp_pos);
+    for (i = num = 0; i < n; ++i) {
+	if (num == 0 || eras[i] != eras[num-1]) eras[num++] = eras[i];
+    }
+    n = num;
+
+    /* without the ECC level, the length descriptor must have been read */
+    if (ndata <= 0 || (ctx->ecl < 0 && n > 0 && eras[0] == 0))
+	return PDF417_ERR_UNCORRECTABLE;
+
+    /* with the syndromes kept during the scan, a codeword costs nothing */
+    if (ctx->numsynd > 0 && ctx->numsynd == ctx->numouts - ndata) {
+	for (i = 1; i <= ctx->numsynd && ctx->synd[i] == 0; ++i) ;
+	if (n == 0 && i > ctx->numsynd) return 0;
+
+	num = eras_dec_rs_synd(work, ctx->codewords, ctx->synd, eras, n,
+	                       ctx->numouts, ctx->numsynd);
+    } else {
+	num = eras_dec_rs(work, ctx->codewords, eras, n, ctx->numouts,
+	                  ctx->numouts - ndata);
+    }
+    if (num == RS_ERR_NOMEM) return PDF417_ERR_NOMEM;
+    if (num < 0) return PDF417_ERR_UNCORRECTABLE;
+
+    /* the codewords no longer match the cells */
+    if (num > 0) ctx->numsynd = 0;
+
+    /* all the erasures are among the positions corrected, unless none are */
+    return (num > ctx->numunread) ? num - ctx->numunread : 0;
+}
+
+
+/*
+ *  Decode the codewords, appending the data to the output buffer. The
+ *  whole symbol is then passed to the output sink in a single write.
+ */
+
+int pdf417_output(PDF417_CTX *ctx) {
+    decode_codewords(ctx);
+
+    if (ctx->nomem) return PDF417_ERR_NOMEM;
+    return pdf417_flush(ctx);
+}
+
+
+/*
+ *  Decode an image in a single call. On success, *data and *len are set
+ *  to the decoded bytes, which stay valid until the context is reset or
+ *  freed. The data is not NUL-terminated and may contain NUL bytes.
+ *  If the context has an output sink, the data has already been written
+ *  to it and *len is 0.
+ */
+
+int pdf417_decode_image(PDF417_CTX *ctx, const PDF417_IMAGE *img,
+                        const char **data, size_t *len) {
+    int err;
+
+    err = pdf417_scan_image(ctx, img);
+    if (err < 0) return err;
+
+    if (ctx->ecc) {
+	err = pdf417_correct(ctx);
+	if (err < 0) return err;
+    }
+
+    err = pdf417_output(ctx);
+    if (err < 0) return err;
+
+    *data = ctx->out;
+    *len = ctx->outlen;
+    return PDF417_OK;
+}
+
+
+/* Same as above, for an image given as one byte per pixel */
+
+int pdf417_decode(PDF417_CTX *ctx, const unsigned char *pixels,
+                  int cols, int rows, int stride,
+                  const char **data, size_t *len) {
+    PDF417_IMAGE img;
+    int err;
+
+    err = pdf417_image_pack(&img, pixels, cols, rows, stride);
+    if (err < 0) return err;
+
+    err = pdf417_decode_image(ctx, &img, data, len);
+    pdf417_image_free(&img);
+
+    return err;
 }
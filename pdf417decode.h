@@ -0,0 +1,233 @@
+/* pdf417decode.h
+
+   Interface to the pdf417decode library.
+
+   All the state used while decoding an image lives in a decoder context,
+   so several images can be decoded at the same time (e.g. from different
+   threads), each one with its own context. The library does no file I/O:
+   the image is passed in as a bitmap or pixel buffer and the decoded data
+   is returned in a memory buffer owned by the context.
+
+*/
+
+#ifndef _PDF417DECODE_H_
+#define _PDF417DECODE_H_
+
+#include <stddef.h>
+
+/*
+ *  Only the functions declared here are exported by the shared library;
+ *  the rest of the library is built with hidden visibility.
+ */
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define PDF417_API  __attribute__((visibility("default")))
+#else
+#define PDF417_API
+#endif
+
+#define MAX_CODEWORDS  (34*90)
+
+/* largest symbol: rows, and data columns between the row indicators */
+
+#define MAX_ROWS  90
+#define MAX_COLS  30
+
+/* ECC codewords at the highest error correction level */
+
+#define MAX_ECC  512
+
+/* Status codes returned by the library functions */
+
+#define PDF417_OK                  0
+#define PDF417_ERR_ARGS           -1  /* invalid arguments */
+#define PDF417_ERR_NOMEM          -2  /* out of memory */
+#define PDF417_ERR_NOTFOUND       -3  /* no codewords found in the image */
+#define PDF417_ERR_OVERFLOW       -4  /* too many codewords */
+#define PDF417_ERR_UNCORRECTABLE  -5  /* errors could not be corrected */
+#define PDF417_ERR_WRITE          -6  /* the output sink failed */
+
+#define PDF417_DONE                1  /* pdf417_scan_row(): the rest of the
+                                         image is not needed */
+
+/* default for the margin option (see PDF417_CTX) */
+
+#define PDF417_MARGIN  4
+
+/* widest image accepted, in pixels: the buffer sizes fit in an int */
+
+#define PDF417_MAX_WIDTH  (1 << 24)
+
+/*
+ *  Output sink: called with the decoded data, once per symbol. Returns
+ *  a negative value on error. Without a sink the data is left in the
+ *  context output buffer.
+ */
+
+typedef int (*PDF417_SINK)(void *arg, const char *buf, size_t len);
+
+/*
+ *  Bitmap image, one bit per pixel (set for black), with the bits in
+ *  the same order as in raw PBM files: the most significant bit of the
+ *  first byte of a row is the leftmost pixel. Images allocated by
+ *  pdf417_image_alloc() have rows padded to whole 64-bit words.
+ */
+
+typedef struct pdf417_image {
+    int cols, rows;
+    size_t stride;              /* bytes from the start of a row to the next */
+    const unsigned char *bits;  /* first row */
+    unsigned char *mem;         /* storage owned by the image, if any */
+} PDF417_IMAGE;
+
+/* a candidate for a codeword, and its distance from what was read */
+
+typedef struct pdf417_cand {
+    int codeword;
+    int dist;
+} PDF417_CAND;
+
+#define PDF417_CONF_MAX  15
+
+/*
+ *  A cell of the symbol matrix. Every scanline that reads the cell votes
+ *  for the codeword it found, with a weight that halves for each module
+ *  the pattern read is away from it; the PDF417_VOTES codewords with
+ *  most weight are kept, each with the nearest pattern read for it.
+ */
+
+#define PDF417_VOTES  4
+
+typedef struct pdf417_vote {
+    unsigned int read;    /* pattern, with its cluster in bits 16 and up */
+    unsigned short codeword;
+    unsigned short weight;        /* 0 for an unused slot */
+    unsigned char dist;   /* distance from read to codeword */
+} PDF417_VOTE;
+
+typedef struct pdf417_cell {
+    PDF417_VOTE vote[PDF417_VOTES];
+    unsigned int read;    /* a pattern read that was not recognised */
+    unsigned short value;        /* codeword of the winning vote, 0 if none */
+    unsigned char seen;   /* the cell was read at all */
+} PDF417_CELL;
+
+typedef struct pdf417_ctx {
+
+    /* options */
+    int debug;   /* debug output level */
+    int dump;    /* output the codewords found in the image */
+    int encfmt;  /* output in pdf417_encode input format */
+    int ecc;     /* perform Reed-Solomon correction in pdf417_decode() */
+    int edges;   /* fall back on edge distances for codewords not read exactly */
+    int soft;    /* set confidence[], and erase codewords with less than this */
+    int margin;  /* ECC codewords still to spare for the scan to stop early */
+
+
+    int codewords[MAX_CODEWORDS];  /* array for the extracted codewords */
+    int erasures[MAX_CODEWORDS];   /* for the Reed-Solomon correction routine */
+    int numouts;
+    int numerasures;
+    int numunread;   /* of the erasures, the cells left unread by an early stop */
+
+    /*
+     *  For each codeword, the 15-bit pattern read and its cluster (in bits
+     *  16 and up), and in soft mode its confidence: how much nearer it is
+     *  to the codeword chosen than to any other (0 if it was not read).
+     */
+    unsigned int cwread[MAX_CODEWORDS];
+    unsigned char confidence[MAX_CODEWORDS];
+
+    /* row scanning state */
+    int cols;
+    const unsigned char *prevrow;
+    unsigned long long *planes;  /* band accumulators, bit-sliced: even rows, odd rows */
+    int *counts;      /* band accumulators, per column: even, odd, all rows */
+    int *changes;     /* edges along a row, per column */
+    unsigned int *words;  /* patterns and edge keys of a row, per 8 columns */
+    int *cws;         /* codewords of a row, per 8 columns */
+    int spilled;      /* counts holds part of the band */
+    int cumsize;
+    int ready;
+    int num;          /* pixel rows in the current band */
+    int rownum;
+    int done;         /* the symbol can be decoded, stop scanning */
+
+    /*
+     *  The symbol matrix: each codeword read is placed at its row and
+     *  column, MAX_COLS cells per row, as told by the row indicators,
+     *  and codewords[] is filled with the winners of the cell votes at
+     *  the end of the scan.
+     */
+    PDF417_CELL cell[MAX_ROWS * MAX_COLS];
+    int lastrow;          /* row of the last band placed */
+    int rivotes[3][30];   /* row indicator values, see add_row() */
+
+    /* symbol size and error correction level (0 and -1 while unknown) */
+    int nrows;
+    int ncols;
+    int ecl;
+
+    /*
+     *  Reed-Solomon syndromes of the cell values (synd[1] to synd[numsynd]),
+     *  updated as the cells change once the symbol size is known, so a
+     *  symbol read with no errors is known to be one straight away
+     *  (numsynd is 0 while they are not kept).
+     */
+    int synd[MAX_ECC + 1];
+    int numsynd;
+
+    struct rs_work *rswork;  /* Reed-Solomon decoder workspace, see ctx_rswork() */
+    int *scratch;            /* 2 * MAX_CODEWORDS, see ctx_scratch() */
+
+    int overflow;
+    int nomem;
+    int ioerr;
+
+    /* output buffer */
+    char *out;
+    size_t outlen;
+    size_t outsize;
+
+    PDF417_SINK sink;
+    void *sink_arg;
+
+} PDF417_CTX;
+
+/*
+ *  The context holds the codewords of a whole symbol and is too big for
+ *  small (e.g. thread) stacks: pdf417_new() allocates and initialises one
+ *  on the heap (NULL if out of memory), pdf417_delete() frees it.
+ */
+
+PDF417_API PDF417_CTX *pdf417_new(void);
+PDF417_API void pdf417_delete(PDF417_CTX *ctx);
+
+PDF417_API void pdf417_init(PDF417_CTX *ctx);
+PDF417_API void pdf417_reset(PDF417_CTX *ctx);
+PDF417_API void pdf417_free(PDF417_CTX *ctx);
+
+PDF417_API int pdf417_image_alloc(PDF417_IMAGE *img, int cols, int rows);
+PDF417_API int pdf417_image_pack(PDF417_IMAGE *img, const unsigned char *pixels,
+                                 int cols, int rows, int stride);
+PDF417_API void pdf417_image_free(PDF417_IMAGE *img);
+
+PDF417_API int pdf417_scan_begin(PDF417_CTX *ctx, int cols);
+PDF417_API int pdf417_scan_row(PDF417_CTX *ctx, const unsigned char *row);
+PDF417_API int pdf417_scan_end(PDF417_CTX *ctx);
+
+PDF417_API int pdf417_scan_image(PDF417_CTX *ctx, const PDF417_IMAGE *img);
+PDF417_API int pdf417_scan(PDF417_CTX *ctx, const unsigned char *pixels,
+                           int cols, int rows, int stride);
+PDF417_API int pdf417_candidates(const PDF417_CTX *ctx, int pos, PDF417_CAND *cand, int k);
+PDF417_API int pdf417_correct(PDF417_CTX *ctx);
+PDF417_API int pdf417_output(PDF417_CTX *ctx);
+PDF417_API int pdf417_flush(PDF417_CTX *ctx);
+
+PDF417_API int pdf417_decode_image(PDF417_CTX *ctx, const PDF417_IMAGE *img,
+                                   const char **data, size_t *len);
+PDF417_API int pdf417_decode(PDF417_CTX *ctx, const unsigned char *pixels,
+                             int cols, int rows, int stride,
+                             const char **data, size_t *len);
+
+#endif /*_PDF417DECODE_H_*/
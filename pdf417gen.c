@@ -0,0 +1,408 @@
+/* pdf417gen.c
+
+   Generator for the codeword lookup table, pdf417_dham.c and its header
+   pdf417_dham.h. It is run by make before the library is built.
+
+   The decoder reads a codeword as a 15-bit pattern: its 17 modules less
+   the first one, always a bar, and the last one, always a space. For
+   each of the 32768 patterns and each cluster, the table gives the
+   nearest codeword of the cluster (from pdf417_patterns.c), or the start
+   or stop pattern, and how far it is. Ties go to the lowest codeword,
+   and to the start and stop patterns last.
+
+   Usage: pdf417gen [-l layout] [-w width] [-m metric] [-d maxdist]
+
+   -l interleaved  the three clusters of a pattern are stored next to
+                   each other, so a lookup touches a single cache line
+                   (the default)
+      planar       one table per cluster
+
+   -w 16  16-bit elements: codeword, start/stop flag, distance, and a
+          flag set if the cluster is (one of) the nearest (the default)
+      32  32-bit elements: distance in the top byte, cluster in the next
+          one (3 for start and stop) and codeword in the low 16 bits
+
+   -m hamming  the number of modules that differ (the default)
+      edge     the largest displacement of a bar or space edge, in
+               modules; patterns that do not have 4 bars and 4 spaces
+               match nothing
+
+   -d maxdist  codewords further away than this are not recorded (the
+               default is 3)
+
+   It also writes dedge[], a hash table of the codewords keyed on their
+   edge to similar edge distances: t1 to t6, the widths of each pair of
+   adjacent elements, in modules. These range from 2 to 9, and are
+   packed 3 bits each, t1 in the top bits. No two codewords (of any
+   cluster) have the same six distances.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pdf417_patterns.h"
+
+
+#define NWORDS   32768
+#define NEDGES   7        /* inner edges of a codeword */
+#define FAR      0xff     /* nothing within maxdist */
+#define START    929      /* codeword numbers for the start and stop */
+#define STOP     930      /* patterns, so they lose all ties */
+#define NCAND    931
+
+/*
+ *  The table has always been built with this start pattern (7 1 2 1 1 1
+ *  1 3) instead of the real one; the real one, and a stop pattern with
+ *  its last three elements run together (7 1 1 3 3 2), were then added
+ *  by hand. Keep it that way, so the decoding does not change.
+ */
+
+#define TABLE_START  0x1fda8
+
+static const struct {
+    UInt32 pattern;
+    int cw;
+} aliases[] = {
+    { PDF417_START, START },
+    { 0x1fd1c, STOP }
+};
+
+#define NALIASES  (sizeof(aliases) / sizeof(aliases[0]))
+
+enum { LAYOUT_INTERLEAVED, LAYOUT_PLANAR };
+enum { METRIC_HAMMING, METRIC_EDGE };
+
+static int layout = LAYOUT_INTERLEAVED;
+static int width = 16;
+static int metric = METRIC_HAMMING;
+static int maxdist = 3;
+
+static char cmdline[256];
+
+static UInt32 table[3][NWORDS];
+
+/* the edge distance hash table, see write_header() for the format */
+
+#define EDGE_BITS  13
+#define EDGE_SIZE  (1 << EDGE_BITS)
+#define EDGE_HASH(key)  (((key) * 0x9e3779b1u) >> (32 - EDGE_BITS))
+#define EDGE_NONE  0xffffffff
+
+static UInt32 edgetab[EDGE_SIZE];
+static int maxprobe;
+
+
+/* positions of the inner edges of a pattern, returns how many there are */
+
+static int edges(UInt32 p, int *e) {
+    int k, n = 0;
+
+    for (k = 1; k < PDF417_MODULES; ++k) {
+	if (((p >> (PDF417_MODULES - k)) ^ (p >> (PDF417_MODULES - 1 - k))) & 1) {
+	    if (n < NEDGES) e[n] = k;
+	    ++n;
+	}
+    }
+    return n;
+}
+
+
+static int distance(UInt32 a, UInt32 b) {
+    int ea[NEDGES], eb[NEDGES];
+    int k, d;
+
+    if (metric == METRIC_HAMMING) {
+	a ^= b;
+	for (d = 0; a; ++d) a &= a - 1;
+	return d;
+    }
+
+    if (edges(a, ea) != NEDGES || edges(b, eb) != NEDGES) return FAR;
+    for (d = 0, k = 0; k < NEDGES; ++k) {
+	if (abs(ea[k] - eb[k]) > d) d = abs(ea[k] - eb[k]);
+    }
+    return d;
+}
+
+
+/* the edge distance key of a pattern, or EDGE_NONE */
+
+static UInt32 edge_key(UInt32 p) {
+    int e[NEDGES + 2];
+    UInt32 key = 0;
+    int k, t;
+
+    e[0] = 0;
+    if (edges(p, e + 1) != NEDGES) return EDGE_NONE;
+    e[NEDGES + 1] = PDF417_MODULES;
+
+    for (k = 0; k < 6; ++k) {
+	t = e[k+2] - e[k];
+	if (t < 2 || t > 9) return EDGE_NONE;
+	key = (key << 3) | (t - 2);
+    }
+    return key;
+}
+
+
+static int edge_add(UInt32 p, int cluster, int cw) {
+    UInt32 key = edge_key(p);
+    int h, n;
+
+    if (key == EDGE_NONE) return -1;
+
+    for (h = EDGE_HASH(key), n = 1; edgetab[h] != EDGE_NONE; h = (h + 1) % EDGE_SIZE, ++n) {
+	if ((edgetab[h] >> 12) == key) return -1;
+    }
+    edgetab[h] = (key << 12) | (cluster << 10) | cw;
+    if (n > maxprobe) maxprobe = n;
+    return 0;
+}
+
+
+static UInt32 candidate(int cluster, int cw) {
+    if (cw == START) return TABLE_START;
+    if (cw == STOP) return PDF417_STOP;
+    return pdf417_patterns[cluster][cw];
+}
+
+
+/* table element for a codeword at distance d */
+
+static UInt32 element(int cluster, int cw, int d, int nearest) {
+    int ss = (cw >= START);
+
+    if (width == 32) {
+	if (d == FAR) return 0xffffffff;
+	return ((UInt32) d << 24) | ((ss ? 3 : cluster) << 16) | (ss ? cw - START : cw);
+    }
+
+    if (d == FAR) return 0x7fff | (nearest << 15);
+    return (ss ? cw - START : cw) | (ss << 10) | (d << 11) | (nearest << 15);
+}
+
+
+static int build_edges(void) {
+    int i, c;
+
+    memset(edgetab, 0xff, sizeof(edgetab));
+    for (i = 0; i < 3; ++i) {
+	for (c = 0; c < 929; ++c) {
+	    if (edge_add(pdf417_patterns[i][c], i, c) < 0) return -1;
+	}
+    }
+    if (edge_add(PDF417_START, 3, 0) < 0 || edge_add(PDF417_STOP, 3, 1) < 0) return -1;
+    return 0;
+}
+
+
+static void build(void) {
+    int word, i, c, k;
+    int best[3], dist[3];
+
+    for (word = 0; word < NWORDS; ++word) {
+	UInt32 p = (1 << (PDF417_MODULES - 1)) | (word << 1);
+	int mind = FAR;
+
+	for (i = 0; i < 3; ++i) {
+	    best[i] = -1;
+	    dist[i] = FAR;
+	    for (c = 0; c < NCAND; ++c) {
+		int d = distance(p, candidate(i, c));
+
+		if (d <= maxdist && d < dist[i]) {
+		    dist[i] = d;
+		    best[i] = c;
+		}
+	    }
+	    for (k = 0; k < NALIASES; ++k) {
+		if (p == aliases[k].pattern) {
+		    best[i] = aliases[k].cw;
+		    dist[i] = distance(p, candidate(i, best[i]));
+		    if (dist[i] > maxdist) dist[i] = maxdist;
+		}
+	    }
+	    if (dist[i] < mind) mind = dist[i];
+	}
+
+	for (i = 0; i < 3; ++i) {
+	    table[i][word] = element(i, best[i], dist[i], dist[i] == mind);
+	}
+    }
+}
+
+
+static void write_header(FILE *pf) {
+    const char *type = (width == 16) ? "UInt16" : "UInt32";
+
+    fprintf(pf, "/* pdf417_dham.h\n\n"
+                "   Generated by %s, do not edit.\n\n"
+                "   Codeword lookup table, see pdf417gen.c.\n\n"
+                "*/\n\n", cmdline);
+    fprintf(pf, "#ifndef _PDF417_DHAM_H_\n#define _PDF417_DHAM_H_\n\n"
+                "#include \"pdf417types.h\"\n\n");
+
+    if (layout == LAYOUT_INTERLEAVED) {
+	fprintf(pf, "extern const %s dham[%d][4];\n\n", type, NWORDS);
+	fprintf(pf, "/* element for a pattern and cluster */\n\n"
+	            "#define DHAM_GET(word, which)  (dham[word][which])\n\n");
+    } else {
+	fprintf(pf, "extern const %s dham[3][%d];\n\n", type, NWORDS);
+	fprintf(pf, "/* element for a pattern and cluster */\n\n"
+	            "#define DHAM_GET(word, which)  (dham[which][word])\n\n");
+    }
+
+    fprintf(pf, "/*\n"
+                " *  The element as distance << 24 | cluster << 16 | codeword, with\n"
+                " *  cluster 3 and codeword 0 or 1 for the start and stop patterns, or\n"
+                " *  0xffffffff if no codeword is near enough.\n"
+                " */\n\n");
+    if (width == 32) {
+	fprintf(pf, "#define DHAM_CODE(e, which)  ((UInt32) (e))\n\n");
+    } else {
+	fprintf(pf, "#define DHAM_CODE(e, which) \\\n"
+	            "    (((e) & 0x7fff) == 0x7fff ? 0xffffffff : \\\n"
+	            "     ((UInt32) (((e) >> 11) & 7) << 24) | \\\n"
+	            "     ((e) & 0x400 ? 0x030000 : (UInt32) (which) << 16) | ((e) & 0x3ff))\n\n");
+	fprintf(pf, "/* non-zero if the cluster is (one of) the nearest to the pattern */\n\n"
+	            "#define DHAM_NEAREST(word, which)  ((DHAM_GET(word, which) >> 15) & 1)\n\n");
+    }
+
+    fprintf(pf, "/*\n"
+                " *  Edge distance table: entries are key << 12 | cluster << 10 | codeword,\n"
+                " *  with cluster 3 and codeword 0 or 1 for the start and stop patterns,\n"
+                " *  or 0x%08x if empty. A key is found within %d entries from its\n"
+                " *  hash, or not at all.\n"
+                " */\n\n", EDGE_NONE, maxprobe);
+    fprintf(pf, "#define DEDGE_BITS   %d\n"
+                "#define DEDGE_NONE   0x%08x\n"
+                "#define DEDGE_PROBE  %d\n"
+                "#define DEDGE_HASH(key)  (((key) * 0x9e3779b1u) >> (32 - DEDGE_BITS))\n\n",
+                EDGE_BITS, EDGE_NONE, maxprobe);
+    fprintf(pf, "/* keys of the start and stop patterns */\n\n"
+                "#define DEDGE_START  0x%05x\n"
+                "#define DEDGE_STOP   0x%05x\n\n",
+                edge_key(PDF417_START), edge_key(PDF417_STOP));
+    fprintf(pf, "extern const UInt32 dedge[1 << DEDGE_BITS];\n\n");
+
+    fprintf(pf, "#endif /*_PDF417_DHAM_H_*/\n");
+}
+
+
+static void write_table(FILE *pf) {
+    const char *fmt = (width == 16) ? "0x%04x" : "0x%08x";
+    int word, i;
+
+    fprintf(pf, "/* pdf417_dham.c\n\n"
+                "   Generated by %s, do not edit.\n\n"
+                "*/\n\n"
+                "#include \"pdf417_dham.h\"\n\n", cmdline);
+
+    if (layout == LAYOUT_INTERLEAVED) {
+	fprintf(pf, "const %s dham[%d][4] = {\n", (width == 16) ? "UInt16" : "UInt32", NWORDS);
+	for (word = 0; word < NWORDS; ++word) {
+	    fprintf(pf, "{ ");
+	    for (i = 0; i < 3; ++i) {
+		fprintf(pf, fmt, table[i][word]);
+		fprintf(pf, ", ");
+	    }
+	    fprintf(pf, "0 }%s\n", (word < NWORDS - 1) ? "," : "");
+	}
+    } else {
+	fprintf(pf, "const %s dham[3][%d] = {\n", (width == 16) ? "UInt16" : "UInt32", NWORDS);
+	for (i = 0; i < 3; ++i) {
+	    fprintf(pf, "{\n");
+	    for (word = 0; word < NWORDS; ++word) {
+		fprintf(pf, (word % 8 == 0) ? "    " : " ");
+		fprintf(pf, fmt, table[i][word]);
+		if (word < NWORDS - 1) fprintf(pf, ",");
+		if (word % 8 == 7) fprintf(pf, "\n");
+	    }
+	    fprintf(pf, "}%s\n", (i < 2) ? "," : "");
+	}
+    }
+    fprintf(pf, "};\n");
+
+    fprintf(pf, "\n\nconst UInt32 dedge[1 << DEDGE_BITS] = {\n");
+    for (i = 0; i < EDGE_SIZE; ++i) {
+	fprintf(pf, (i % 8 == 0) ? "    0x%08x" : " 0x%08x", edgetab[i]);
+	if (i < EDGE_SIZE - 1) fprintf(pf, ",");
+	if (i % 8 == 7) fprintf(pf, "\n");
+    }
+    fprintf(pf, "};\n");
+}
+
+
+static void usage(const char *myname) {
+    fprintf(stderr, "usage: %s [-l interleaved|planar] [-w 16|32] "
+                    "[-m hamming|edge] [-d maxdist]\n", myname);
+    exit(1);
+}
+
+
+int main(int argc, char **argv) {
+    FILE *pf;
+    char *myname = argv[0];
+
+    for ( ; argc > 2; argc -= 2, argv += 2) {
+        if (strcmp(argv[1], "-l") == 0) {
+            if (strcmp(argv[2], "interleaved") == 0)
+                layout = LAYOUT_INTERLEAVED;
+            else if (strcmp(argv[2], "planar") == 0)
+                layout = LAYOUT_PLANAR;
+            else
+                usage(myname);
+        } else if (strcmp(argv[1], "-w") == 0) {
+            width = atoi(argv[2]);
+            if (width != 16 && width != 32) usage(myname);
+        } else if (strcmp(argv[1], "-m") == 0) {
+            if (strcmp(argv[2], "hamming") == 0)
+                metric = METRIC_HAMMING;
+            else if (strcmp(argv[2], "edge") == 0)
+                metric = METRIC_EDGE;
+            else
+                usage(myname);
+        } else if (strcmp(argv[1], "-d") == 0) {
+            maxdist = atoi(argv[2]);
+        } else {
+            usage(myname);
+        }
+    }
+    if (argc > 1) usage(myname);
+
+    /* 16-bit elements have 3 bits of distance, 7 meaning none */
+    if (maxdist < 0 || maxdist > ((width == 16) ? 6 : FAR - 1)) {
+	fprintf(stderr, "%s: maxdist out of range\n", myname);
+	exit(1);
+    }
+
+    snprintf(cmdline, sizeof(cmdline), "pdf417gen -l %s -w %d -m %s -d %d",
+             (layout == LAYOUT_INTERLEAVED) ? "interleaved" : "planar",
+             width, (metric == METRIC_HAMMING) ? "hamming" : "edge", maxdist);
+
+    build();
+    if (build_edges() < 0) {
+	fprintf(stderr, "%s: codewords with the same edge distances\n", myname);
+	exit(1);
+    }
+
+    pf = fopen("pdf417_dham.h", "w");
+    if (pf == NULL) {
+	fprintf(stderr, "%s: could not create pdf417_dham.h\n", myname);
+	exit(1);
+    }
+    write_header(pf);
+    if (fclose(pf) != 0) exit(1);
+
+    pf = fopen("pdf417_dham.c", "w");
+    if (pf == NULL) {
+	fprintf(stderr, "%s: could not create pdf417_dham.c\n", myname);
+	exit(1);
+    }
+    write_table(pf);
+    if (fclose(pf) != 0) exit(1);
+
+    return 0;
+}
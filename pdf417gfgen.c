@@ -0,0 +1,116 @@
+/* pdf417gfgen.c
+
+   Generator for the GF(929) arithmetic tables of the Reed-Solomon
+   decoder, pdf417_gf.c and its header pdf417_gf.h. It is run by make
+   before the library is built, so the tables are read-only data shared
+   by all the decoder contexts (and threads).
+
+   Usage: pdf417gfgen
+
+   The tables are the powers of 3, the generator of the field, twice
+   over (so the sum of two logarithms can index them directly), the
+   logarithms to the base 3, and the multiplicative inverses.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define GPRIME  929
+
+static int exp_tab[2 * (GPRIME - 1)];
+static int log_tab[GPRIME];
+static int inv_tab[GPRIME];
+
+
+static void build(void) {
+    int i, p = 1;
+
+    for (i = 0; i < GPRIME - 1; i++) {
+	exp_tab[i] = exp_tab[i + GPRIME - 1] = p;
+	log_tab[p] = i;
+	p = (p * 3) % GPRIME;
+    }
+    log_tab[0] = GPRIME - 1;
+
+    inv_tab[0] = 0;
+    for (i = 1; i < GPRIME; i++) {
+	inv_tab[i] = exp_tab[GPRIME - 1 - log_tab[i]];
+    }
+}
+
+
+static void write_header(FILE *pf) {
+    fprintf(pf, "/* pdf417_gf.h\n\n"
+                "   Generated by pdf417gfgen, do not edit.\n\n"
+                "   GF(929) arithmetic tables, see pdf417gfgen.c.\n\n"
+                "*/\n\n");
+    fprintf(pf, "#ifndef _PDF417_GF_H_\n#define _PDF417_GF_H_\n\n"
+                "#include \"pdf417types.h\"\n\n");
+    fprintf(pf, "/* 3**i for 0 <= i < %d, the powers of 3 twice over */\n\n"
+                "extern const UInt16 gf929_exp[%d];\n\n",
+                2 * (GPRIME - 1), 2 * (GPRIME - 1));
+    fprintf(pf, "/* logarithms to the base 3 (%d for 0) */\n\n"
+                "extern const UInt16 gf929_log[%d];\n\n", GPRIME - 1, GPRIME);
+    fprintf(pf, "/* multiplicative inverses (0 for 0) */\n\n"
+                "extern const UInt16 gf929_inv[%d];\n\n", GPRIME);
+    fprintf(pf, "#endif /*_PDF417_GF_H_*/\n");
+}
+
+
+static void write_array(FILE *pf, const char *name, const int *tab, int n) {
+    int i;
+
+    fprintf(pf, "\n\nconst UInt16 %s[%d] = {\n", name, n);
+    for (i = 0; i < n; i++) {
+	fprintf(pf, (i % 12 == 0) ? "    %3d" : " %3d", tab[i]);
+	if (i < n - 1) fprintf(pf, ",");
+	if (i % 12 == 11) fprintf(pf, "\n");
+    }
+    if (n % 12 != 0) fprintf(pf, "\n");
+    fprintf(pf, "};\n");
+}
+
+
+static void write_table(FILE *pf) {
+    fprintf(pf, "/* pdf417_gf.c\n\n"
+                "   Generated by pdf417gfgen, do not edit.\n\n"
+                "*/\n\n"
+                "#include \"pdf417_gf.h\"\n");
+    write_array(pf, "gf929_exp", exp_tab, 2 * (GPRIME - 1));
+    write_array(pf, "gf929_log", log_tab, GPRIME);
+    write_array(pf, "gf929_inv", inv_tab, GPRIME);
+}
+
+
+int main(int argc, char **argv) {
+    FILE *pf;
+    char *myname = argv[0];
+
+    if (argc > 1) {
+	fprintf(stderr, "usage: %s\n", myname);
+	exit(1);
+    }
+
+    build();
+
+    pf = fopen("pdf417_gf.h", "w");
+    if (pf == NULL) {
+	fprintf(stderr, "%s: could not create pdf417_gf.h\n", myname);
+	exit(1);
+    }
+    write_header(pf);
+    if (fclose(pf) != 0) exit(1);
+
+    pf = fopen("pdf417_gf.c", "w");
+    if (pf == NULL) {
+	fprintf(stderr, "%s: could not create pdf417_gf.c\n", myname);
+	exit(1);
+    }
+    write_table(pf);
+    if (fclose(pf) != 0) exit(1);
+
+    return 0;
+}
@@ -0,0 +1,457 @@
+/* pdf417image.c
+
+   Packed bitmap images for pdf417decode, and the kernels that scan
+   them.
+
+   Images are stored one bit per pixel, in the same bit order as raw
+   (P4) PBM files: the most significant bit of the first byte of a row
+   is the leftmost pixel, and a set bit is black. Rows are padded to a
+   whole number of 64-bit words, so the pixel loops can work on a word
+   at a time.
+
+*/
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "pdf417image.h"
+#include "pdf417simd.h"
+#include "pdf417_patterns.h"
+
+
+/* Allocate a cleared (all white) image */
+
+int pdf417_image_alloc(PDF417_IMAGE *img, int cols, int rows) {
+    size_t stride;
+
+    if (cols <= 0 || cols > PDF417_MAX_WIDTH || rows <= 0) return PDF417_ERR_ARGS;
+
+    stride = (((size_t) cols + 63) / 64) * sizeof(UInt64);
+
+    img->mem = calloc((size_t) rows * stride / sizeof(UInt64), sizeof(UInt64));
+    if (img->mem == NULL) return PDF417_ERR_NOMEM;
+
+    img->cols = cols;
+    img->rows = rows;
+    img->stride = stride;
+    img->bits = (unsigned char *) img->mem;
+
+    return PDF417_OK;
+}
+
+
+void pdf417_image_free(PDF417_IMAGE *img) {
+    free(img->mem);
+    img->mem = NULL;
+    img->bits = NULL;
+}
+
+
+/* Pack a buffer of one byte per pixel (non-zero for black) into an image */
+
+int pdf417_image_pack(PDF417_IMAGE *img, const unsigned char *pixels,
+                      int cols, int rows, int stride) {
+    int i, j, err;
+
+    if (pixels == NULL || stride < cols) return PDF417_ERR_ARGS;
+
+    err = pdf417_image_alloc(img, cols, rows);
+    if (err < 0) return err;
+
+    for (i = 0; i < rows; ++i) {
+	const unsigned char *p = pixels + (size_t) i * stride;
+	unsigned char *row = img->mem + (size_t) i * img->stride;
+
+	for (j = 0; j < cols; ++j) {
+	    if (p[j]) row[j >> 3] |= 0x80 >> (j & 7);
+	}
+    }
+
+    return PDF417_OK;
+}
+
+
+static ALWAYS_INLINE int popcount64(UInt64 x) {
+#ifdef __GNUC__
+    return __builtin_popcountll(x);
+#else
+    int n;
+
+    for (n = 0; x; ++n) x &= x - 1;
+    return n;
+#endif
+}
+
+
+/*
+ *  Row difference: count the pixels that differ between two packed
+ *  rows, XORing them a word at a time. The rows need not be aligned,
+ *  and any padding bits after the last pixel are ignored.
+ *
+ *  The band detection only needs to know whether the count is below
+ *  fuzz or above thresh, so the count stops as soon as it goes above
+ *  thresh, or as soon as it cannot reach fuzz anymore with the pixels
+ *  left. The result is exact only when it lies between the two.
+ */
+
+#define DIFF_BLOCK  32  /* bytes counted between early exit checks */
+
+
+/* difference over the last (at most DIFF_BLOCK) bytes of a row */
+
+static ALWAYS_INLINE int row_diff_tail(const unsigned char *row,
+                                       const unsigned char *prev, int cols) {
+    int nbytes = (cols + 7) / 8;
+    int i, d = 0;
+    UInt64 a, b;
+
+    /* all but the last byte, a word at a time */
+    for (i = 0; i + 8 < nbytes; i += 8) {
+	memcpy(&a, row + i, 8);
+	memcpy(&b, prev + i, 8);
+	d += popcount64(a ^ b);
+    }
+    for ( ; i < nbytes - 1; ++i) {
+	d += popcount64(row[i] ^ prev[i]);
+    }
+
+    /* the last byte may contain padding */
+    d += popcount64((row[i] ^ prev[i]) & (0xff00 >> (cols - 8 * i)) & 0xff);
+
+    return d;
+}
+
+
+static ALWAYS_INLINE int row_diff_words(const unsigned char *row,
+                                        const unsigned char *prev,
+                                        int cols, int fuzz, int thresh) {
+    int nbytes = (cols + 7) / 8;
+    int i, k, d = 0;
+    UInt64 a, b;
+
+    for (i = 0; i + DIFF_BLOCK < nbytes; i += DIFF_BLOCK) {
+	for (k = i; k < i + DIFF_BLOCK; k += 8) {
+	    memcpy(&a, row + k, 8);
+	    memcpy(&b, prev + k, 8);
+	    d += popcount64(a ^ b);
+	}
+	if (d > thresh) return d;
+	if (d + 8 * (nbytes - i - DIFF_BLOCK) < fuzz) return d;
+    }
+
+    return d + row_diff_tail(row + i, prev + i, cols - 8 * i);
+}
+
+
+static int row_diff_generic(const unsigned char *row, const unsigned char *prev,
+                            int cols, int fuzz, int thresh) {
+    return row_diff_words(row, prev, cols, fuzz, thresh);
+}
+
+
+#ifdef PDF417_X86_SIMD
+
+/* same as above, with the hardware popcount instruction */
+
+TARGET("popcnt")
+static int row_diff_popcnt(const unsigned char *row, const unsigned char *prev,
+                           int cols, int fuzz, int thresh) {
+    return row_diff_words(row, prev, cols, fuzz, thresh);
+}
+
+
+/*
+ *  AVX2 version: 32 bytes at a time, counting the bits of each byte
+ *  with a nibble lookup table (vpshufb) and summing the byte counts
+ *  into four 64-bit lanes (vpsadbw).
+ */
+
+TARGET("avx2,popcnt")
+static int row_diff_avx2(const unsigned char *row, const unsigned char *prev,
+                         int cols, int fuzz, int thresh) {
+    int nbytes = (cols + 7) / 8;
+    int i, d;
+    UInt64 lanes[4];
+    const __m256i nibble = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                            1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3,
+                                            1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (i = 0; i + DIFF_BLOCK < nbytes; i += DIFF_BLOCK) {
+	__m256i x, n;
+
+	x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (row + i)),
+	                     _mm256_loadu_si256((const __m256i *) (prev + i)));
+	n = _mm256_add_epi8(_mm256_shuffle_epi8(nibble, _mm256_and_si256(x, low)),
+	                    _mm256_shuffle_epi8(nibble,
+	                        _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+	sum = _mm256_add_epi64(sum, _mm256_sad_epu8(n, _mm256_setzero_si256()));
+
+	/* check for an early exit every 4 blocks */
+	if ((i & (4 * DIFF_BLOCK - 1)) == 3 * DIFF_BLOCK) {
+	    _mm256_storeu_si256((__m256i *) lanes, sum);
+	    d = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	    if (d > thresh) return d;
+	    if (d + 8 * (nbytes - i - DIFF_BLOCK) < fuzz) return d;
+	}
+    }
+
+    _mm256_storeu_si256((__m256i *) lanes, sum);
+    d = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    return d + row_diff_tail(row + i, prev + i, cols - 8 * i);
+}
+
+#endif
+
+
+/*
+ *  Add a packed row to the bit-sliced band accumulator: a ripple-carry
+ *  add of the row bits into the counter planes, for 64 columns at once.
+ *  The caller must empty the planes with band_counts() every BAND_SPILL
+ *  rows.
+ */
+
+void band_add(UInt64 *planes, const unsigned char *row, int cols) {
+    int nbytes = (cols + 7) / 8;
+    int i, p;
+    UInt64 x, carry;
+
+    for (i = 0; i < nbytes; i += 8, planes += NPLANES) {
+	if (nbytes - i >= 8) {
+	    memcpy(&x, row + i, 8);
+	} else {
+	    x = 0;
+	    memcpy(&x, row + i, nbytes - i);
+	}
+	for (p = 0; x != 0 && p < NPLANES; ++p) {
+	    carry = planes[p] & x;
+	    planes[p] ^= x;
+	    x = carry;
+	}
+    }
+}
+
+
+/*
+ *  The bits of a byte, leftmost pixel first, spread to the low bits of
+ *  the eight bytes of a word: each set bit is moved 9 places further
+ *  than the one before, and none of them overlap.
+ */
+
+#define SPREAD(b)  ((((UInt64) (b) * 0x8040201008040201ULL) >> 7) & 0x0101010101010101ULL)
+
+
+/* Add the counts held in the bit-sliced accumulator to counts[] */
+
+void band_counts(const UInt64 *planes, int *counts, int cols) {
+    int c, j, k, n, p;
+    UInt64 v;
+
+    for (c = 0; c < cols; c += 64, planes += NPLANES) {
+	const unsigned char *bits = (const unsigned char *) planes;
+
+	/* eight columns at a time, the count of each in a byte of v (so
+	   NPLANES must not be over 8) */
+	n = (cols - c < 64) ? cols - c : 64;
+	for (k = 0; k < n; k += 8) {
+	    v = 0;
+	    for (p = 0; p < NPLANES; ++p) v += SPREAD(bits[8 * p + k / 8]) << p;
+	    for (j = 0; j < 8 && k + j < n; ++j) counts[c + k + j] += (v >> (8 * j)) & 0xff;
+	}
+    }
+}
+
+
+/*
+ *  An edge at x pixels from the start of a codeword scale pixels wide
+ *  is at module floor((34x + scale) / (2 scale)), which is 17x/scale
+ *  rounded to nearest. The division is replaced by a multiplication by
+ *  m = ceil(2^QBITS / (2 scale)), computed once per codeword, and a
+ *  shift: with n = 34x + scale <= 35 scale, the result is exact as long
+ *  as n * 2 scale < 2^QBITS, that is for 70 scale^2 < 2^QBITS.
+ */
+
+#define QBITS       40
+#define QMAX_SCALE  100000  /* below sqrt(2^40 / 70) */
+
+
+/* the pattern of a bar covering modules s to e-1, shifted right once */
+
+static ALWAYS_INLINE UInt32 range_mask(int s, int e) {
+    /* we know we always start with 1, end with 0 */
+    if (s < 1) s = 1;
+    if (e > 16) e = 16;
+    if (e <= s) return 0;
+    return ((1u << (e - s)) - 1) << (16 - e);
+}
+
+
+static ALWAYS_INLINE UInt64 module_recip(int scale) {
+    return (((UInt64) 1 << QBITS) + 2 * scale - 1) / (2 * scale);
+}
+
+
+static ALWAYS_INLINE int to_modules(int x, int scale, UInt64 m) {
+    if (scale > QMAX_SCALE) return (34LL * x + scale) / (2LL * scale);
+    return ((UInt64) (34 * x + scale) * m) >> QBITS;
+}
+
+
+static UInt32 quantize_cw(const int *edge) {
+    int scale = edge[8] - edge[0];
+    UInt64 m = module_recip(scale);
+    UInt32 word = 0;
+    int k, s, e;
+
+    for (k = 0; k < 8; k += 2) {
+	s = to_modules(edge[k] - edge[0], scale, m);
+	e = to_modules(edge[k+1] - edge[0], scale, m);
+	word |= range_mask(s, e);
+    }
+    return word;
+}
+
+
+/*
+ *  Edge to similar edge distances of a codeword: t1 to t6, the widths of
+ *  each pair of adjacent bars and spaces, rounded to modules the same
+ *  way. Ink spread makes the bars wider and the spaces narrower by the
+ *  same amount, so it leaves them unchanged. Returns them packed 3 bits
+ *  each, t1 first (the dedge[] key, see pdf417gen.c), or EDGE_NOKEY if
+ *  one is not between 2 and 9.
+ */
+
+UInt32 edge_key(const int *edge) {
+    int scale = edge[8] - edge[0];
+    UInt64 m = module_recip(scale);
+    UInt32 key = 0;
+    int k, t;
+
+    for (k = 0; k < 6; ++k) {
+	t = to_modules(edge[k+2] - edge[k], scale, m);
+	if (t < 2 || t > 9) return EDGE_NOKEY;
+	key = (key << 3) | (t - 2);
+    }
+    return key;
+}
+
+
+static void quantize_row_generic(const int *edges, int ncw, UInt32 *words) {
+    int i;
+
+    for (i = 0; i < ncw; ++i) words[i] = quantize_cw(edges + 8 * i);
+}
+
+
+#ifdef PDF417_X86_SIMD
+
+/*
+ *  AVX2 version: 8 codewords at a time, one per 32-bit lane, gathering
+ *  the same edge of each. The reciprocals have 32 fraction bits so the
+ *  products are done with vpmuludq; codewords too wide for that go
+ *  through the scalar code.
+ */
+
+#define QMAX_SCALE32  7800  /* below sqrt(2^32 / 70) */
+
+TARGET("avx2")
+static ALWAYS_INLINE __m256i quantize8(__m256i x, __m256i scale, __m256i m) {
+    __m256i n, lo, hi;
+
+    n = _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(34)), scale);
+    lo = _mm256_srli_epi64(_mm256_mul_epu32(n, m), 32);
+    hi = _mm256_mul_epu32(_mm256_srli_epi64(n, 32), _mm256_srli_epi64(m, 32));
+    return _mm256_blend_epi32(lo, hi, 0xaa);
+}
+
+
+TARGET("avx2")
+static void quantize_row_avx2(const int *edges, int ncw, UInt32 *words) {
+    const __m256i idx = _mm256_setr_epi32(0, 8, 16, 24, 32, 40, 48, 56);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i sixteen = _mm256_set1_epi32(16);
+    UInt32 recip[8];
+    int i, k, wide;
+
+    for (i = 0; i + 8 <= ncw; i += 8) {
+	const int *edge = edges + 8 * i;
+	__m256i base, scale, m, s, e, n, word;
+
+	wide = 0;
+	for (k = 0; k < 8; ++k) {
+	    int sc = edge[8*k+8] - edge[8*k];
+
+	    if (sc > QMAX_SCALE32) wide = 1;
+	    recip[k] = (((UInt64) 1 << 32) + 2 * sc - 1) / (2 * sc);
+	}
+	if (wide) {
+	    quantize_row_generic(edge, 8, words + i);
+	    continue;
+	}
+
+	base = _mm256_i32gather_epi32(edge, idx, 4);
+	scale = _mm256_sub_epi32(_mm256_i32gather_epi32(edge + 8, idx, 4), base);
+	m = _mm256_loadu_si256((const __m256i *) recip);
+	word = _mm256_setzero_si256();
+
+	for (k = 0; k < 8; k += 2) {
+	    s = _mm256_sub_epi32(_mm256_i32gather_epi32(edge + k, idx, 4), base);
+	    e = _mm256_sub_epi32(_mm256_i32gather_epi32(edge + k + 1, idx, 4), base);
+	    s = _mm256_max_epi32(quantize8(s, scale, m), one);
+	    e = _mm256_min_epi32(quantize8(e, scale, m), sixteen);
+	    n = _mm256_max_epi32(_mm256_sub_epi32(e, s), _mm256_setzero_si256());
+	    word = _mm256_or_si256(word,
+	               _mm256_sllv_epi32(_mm256_sub_epi32(_mm256_sllv_epi32(one, n), one),
+	                                 _mm256_sub_epi32(sixteen, e)));
+	}
+	_mm256_storeu_si256((__m256i *) (words + i), word);
+    }
+
+    quantize_row_generic(edges + 8 * i, ncw - i, words + i);
+}
+
+#endif
+
+
+void cw_distances(UInt32 word, int cluster, unsigned char *dist) {
+    const UInt32 *p = pdf417_patterns[cluster];
+    int c;
+
+    /* the patterns less their first and last modules */
+    for (c = 0; c < 929; ++c) dist[c] = popcount64(((p[c] >> 1) & 0x7fff) ^ word);
+}
+
+
+static int (*row_diff_fn)(const unsigned char *, const unsigned char *,
+                          int, int, int) = row_diff_generic;
+static void (*quantize_row_fn)(const int *, int, UInt32 *) = quantize_row_generic;
+
+#ifdef PDF417_X86_SIMD
+
+/* pick the best kernels for this CPU, before any thread is started */
+
+STARTUP static void image_cpu_init(void) {
+    CPU_INIT();
+    if (CPU_SUPPORTS("avx2") && CPU_SUPPORTS("popcnt"))
+	row_diff_fn = row_diff_avx2;
+    else if (CPU_SUPPORTS("popcnt"))
+	row_diff_fn = row_diff_popcnt;
+    if (CPU_SUPPORTS("avx2"))
+	quantize_row_fn = quantize_row_avx2;
+}
+
+#endif
+
+
+int row_diff(const unsigned char *row, const unsigned char *prev,
+             int cols, int fuzz, int thresh) {
+    return row_diff_fn(row, prev, cols, fuzz, thresh);
+}
+
+
+void quantize_row(const int *edges, int ncw, UInt32 *words) {
+    quantize_row_fn(edges, ncw, words);
+}
@@ -0,0 +1,46 @@
+/* pdf417image.h
+
+   Internal routines working on packed bitmap rows (see PDF417_IMAGE in
+   pdf417decode.h).
+
+*/
+
+#ifndef _PDF417IMAGE_H_
+#define _PDF417IMAGE_H_
+
+#include "pdf417decode.h"
+#include "pdf417types.h"
+
+int row_diff(const unsigned char *row, const unsigned char *prev,
+             int cols, int fuzz, int thresh);
+
+/*
+ *  Bit-sliced band accumulator: for every 64 columns, NPLANES words hold
+ *  bit p of the count of black pixels of each column in word p, so it
+ *  can count up to BAND_SPILL rows before it has to be emptied.
+ */
+
+#define NPLANES     8
+#define BAND_SPILL  ((1 << NPLANES) - 1)
+
+void band_add(UInt64 *planes, const unsigned char *row, int cols);
+void band_counts(const UInt64 *planes, int *counts, int cols);
+
+/*
+ *  Module quantization: edges[] holds the offsets of the bar and space
+ *  edges along a row, 8 per codeword plus the start of the one after
+ *  the last. Each edge is rounded to the nearest of the 17 modules of
+ *  its codeword, giving the 15-bit patterns of the ncw codewords.
+ */
+
+void quantize_row(const int *edges, int ncw, UInt32 *words);
+
+#define EDGE_NOKEY  0xffffffff
+
+UInt32 edge_key(const int *edge);
+
+/* Hamming distances from a 15-bit pattern to the 929 codewords of a cluster */
+
+void cw_distances(UInt32 word, int cluster, unsigned char *dist);
+
+#endif /*_PDF417IMAGE_H_*/
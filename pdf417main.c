@@ -0,0 +1,359 @@
+/* pdf417main.c
+
+   Command line front-end for the pdf417decode library.
+
+   Usage: To decode a pbm file "jac.pbm", do "./pdf417decode jac.pbm".
+   The file is written to stdout.
+
+   Several files (or a list of files, with -l) can be decoded in one run;
+   they are then decoded in parallel by a pool of worker threads, each
+   with its own decoder context, and the output of every file is written
+   in turn, in the order the files were given, after a line with the
+   file name.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pdf417decode.h"
+#include "pdf417pbm.h"
+
+
+static const char *myname;
+static int debug, dump, encfmt, ecc, edges, soft, margin = PDF417_MARGIN;
+
+
+/* output sink: write the decoded data to a stdio stream */
+
+static int write_stream(void *arg, const char *buf, size_t len) {
+    return (fwrite(buf, 1, len, (FILE *) arg) == len) ? 0 : -1;
+}
+
+
+static void ctx_init(PDF417_CTX *ctx) {
+    pdf417_init(ctx);
+    ctx->debug = debug;
+    ctx->dump = dump;
+    ctx->encfmt = encfmt;
+    ctx->ecc = ecc;
+    ctx->edges = edges;
+    ctx->soft = soft;
+    ctx->margin = margin;
+    ctx->sink = write_stream;
+}
+
+
+/* list the codewords with a low confidence, and their best candidates */
+
+static void list_uncertain(PDF417_CTX *ctx, FILE *out) {
+    PDF417_CAND cand[3];
+    int i, j, n;
+
+    for (i = 0; i < ctx->numouts; ++i) {
+	if (ctx->confidence[i] >= soft) continue;
+	fprintf(out, "Codeword %d: confidence %d, candidates", i, ctx->confidence[i]);
+	n = pdf417_candidates(ctx, i, cand, 3);
+	for (j = 0; j < n; ++j) fprintf(out, " %d (%d)", cand[j].codeword, cand[j].dist);
+	fprintf(out, "\n");
+    }
+}
+
+
+/*
+ *  Decode one file, writing the results to out. Returns 0 on success,
+ *  or -1 (after printing a message) if the file could not be decoded.
+ */
+
+static int decode_file(PDF417_CTX *ctx, const char *path, FILE *out) {
+    FILE *pf;
+    PDF417_IMAGE img;
+    PBM_MAP map;
+    int num, ndata;
+
+    pdf417_reset(ctx);
+    ctx->sink_arg = out;
+
+    /*
+     *  Raw PBM files are decoded in place. Anything else (plain files,
+     *  pipes, or "-" for the standard input) is decoded as it is read,
+     *  a row at a time.
+     */
+    if (strcmp(path, "-") == 0) {
+      num = pbm_scan(stdin, ctx);
+    } else if ((num = pbm_mapimage(path, &img, &map)) == PDF417_OK) {
+      num = pdf417_scan_image(ctx, &img);
+      pbm_unmap(&map);
+    } else if (num == PBM_NOMAP) {
+      pf = fopen(path, "r");
+      if (pf == NULL) {
+        fprintf(stderr, "%s: could not open file: %s\n", myname, path);
+        return -1;
+      }
+      num = pbm_scan(pf, ctx);
+      fclose(pf);
+    }
+    pdf417_flush(ctx);
+
+    if (num == PDF417_ERR_NOMEM) {
+      fprintf(stderr, "%s: out of memory\n", myname);
+      return -1;
+    } else if (num == PDF417_ERR_ARGS) {
+      fprintf(stderr, "%s: bad or truncated PBM file: %s\n", myname, path);
+      return -1;
+    } else if (num == PDF417_ERR_NOTFOUND) {
+      fprintf(stderr, "%s: no PDF417 symbol found: %s\n", myname, path);
+      return -1;
+    } else if (num == PDF417_ERR_OVERFLOW) {
+      fprintf(stderr, "%s: too many codewords: %s\n", myname, path);
+      return -1;
+    }
+
+    if (dump && soft) list_uncertain(ctx, out);
+
+    if (ecc) {
+	/* as in pdf417_correct(): the ECC level, else the length descriptor */
+	ndata = (ctx->ecl >= 0) ? ctx->numouts - (2 << ctx->ecl) : ctx->codewords[0];
+	fprintf(out, "Total codewords = %d (%d data, %d ECC)\n",
+	        ctx->numouts, ndata, ctx->numouts - ndata);
+	if (ctx->numunread > 0)
+	    fprintf(out, "%d codewords not read (the scan stopped early)\n", ctx->numunread);
+
+	num = pdf417_correct(ctx);
+	if (num == 0)
+	    fprintf(out, "No errors \n");
+	else if (num < 0)
+	    fprintf(out, "Errors detected, but data could not be corrected\n");
+	else
+	    fprintf(out, "%d codewords corrected\n\n", num);
+    }
+
+    pdf417_output(ctx);
+
+    return 0;
+}
+
+
+/*
+ *  Batch mode. The workers take the next file from the job list, decode
+ *  it into a memory stream, and mark it done; the main thread waits for
+ *  the jobs in order and writes their output, so the output does not
+ *  depend on the number of threads.
+ */
+
+typedef struct job {
+    const char *path;
+    char *buf;         /* output, including the file name line */
+    size_t len;
+    int err;
+    int done;
+} JOB;
+
+static JOB *jobs;
+static int numjobs, nextjob;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobdone = PTHREAD_COND_INITIALIZER;
+
+
+static void *worker(void *arg) {
+    PDF417_CTX *ctx = arg;
+    JOB *job;
+    FILE *out;
+
+    ctx_init(ctx);
+
+    for (;;) {
+	pthread_mutex_lock(&lock);
+	job = (nextjob < numjobs) ? &jobs[nextjob++] : NULL;
+	pthread_mutex_unlock(&lock);
+	if (job == NULL) break;
+
+	out = open_memstream(&job->buf, &job->len);
+	if (out == NULL) {
+	    fprintf(stderr, "%s: out of memory\n", myname);
+	    job->err = -1;
+	} else {
+	    fprintf(out, "==> %s <==\n", job->path);
+	    job->err = decode_file(ctx, job->path, out);
+	    fclose(out);
+	}
+
+	pthread_mutex_lock(&lock);
+	job->done = 1;
+	pthread_cond_broadcast(&jobdone);
+	pthread_mutex_unlock(&lock);
+    }
+
+    pdf417_free(ctx);
+    return NULL;
+}
+
+
+static int add_job(const char *path) {
+    static int size;
+
+    if (numjobs == size) {
+	JOB *p = realloc(jobs, (size ? 2 * size : 64) * sizeof(JOB));
+
+	if (p == NULL) return -1;
+	jobs = p;
+	size = size ? 2 * size : 64;
+    }
+    memset(&jobs[numjobs], 0, sizeof(JOB));
+    jobs[numjobs++].path = path;
+    return 0;
+}
+
+
+/* add the files listed in a list file, one per line */
+
+static int read_list(const char *listname) {
+    FILE *pf;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t n;
+    int err = 0;
+
+    pf = (strcmp(listname, "-") == 0) ? stdin : fopen(listname, "r");
+    if (pf == NULL) {
+	fprintf(stderr, "%s: could not open file: %s\n", myname, listname);
+	return -1;
+    }
+
+    while ((n = getline(&line, &size, pf)) >= 0) {
+	while (n > 0 && (line[n-1] == '\n' || line[n-1] == '\r')) line[--n] = '\0';
+	if (n == 0) continue;
+	if (add_job(line) < 0) {
+	    fprintf(stderr, "%s: out of memory\n", myname);
+	    err = -1;
+	    break;
+	}
+	line = NULL;
+	size = 0;
+    }
+    free(line);
+
+    if (pf != stdin) fclose(pf);
+    return err;
+}
+
+
+static int run_batch(int nthreads) {
+    pthread_t *threads;
+    PDF417_CTX *ctxs;
+    int i, n, err = 0;
+
+    if (nthreads > numjobs) nthreads = numjobs;
+
+    /* the contexts are large, keep them off the thread stacks */
+    threads = malloc(nthreads * sizeof(pthread_t));
+    ctxs = malloc(nthreads * sizeof(PDF417_CTX));
+    if (threads == NULL || ctxs == NULL) {
+	fprintf(stderr, "%s: out of memory\n", myname);
+	free(threads);
+	free(ctxs);
+	return -1;
+    }
+
+    for (n = 0; n < nthreads; ++n) {
+	if (pthread_create(&threads[n], NULL, worker, &ctxs[n]) != 0) break;
+    }
+    if (n == 0) {
+	fprintf(stderr, "%s: could not start worker threads\n", myname);
+	free(threads);
+	free(ctxs);
+	return -1;
+    }
+
+    for (i = 0; i < numjobs; ++i) {
+	pthread_mutex_lock(&lock);
+	while (!jobs[i].done) pthread_cond_wait(&jobdone, &lock);
+	pthread_mutex_unlock(&lock);
+
+	if (jobs[i].buf) {
+	    fwrite(jobs[i].buf, 1, jobs[i].len, stdout);
+	    free(jobs[i].buf);
+	}
+	putchar('\n');
+	if (jobs[i].err < 0) err = -1;
+    }
+
+    while (n > 0) pthread_join(threads[--n], NULL);
+    free(threads);
+    free(ctxs);
+
+    return err;
+}
+
+
+int main(int argc, char **argv) {
+    int nthreads = 0, batch = 0;
+    PDF417_CTX *ctx;
+
+    myname = argv[0];
+
+    for ( ; argc > 1; --argc, ++argv) {
+        if (strcmp(argv[1], "-d") == 0)
+            ++debug;
+        else if (strcmp(argv[1], "-c") == 0)
+            dump = 1;
+        else if (strcmp(argv[1], "-e") == 0)
+            encfmt = 1;
+        else if (strcmp(argv[1], "-rs") == 0)
+            ecc = 1;
+        else if (strcmp(argv[1], "-t") == 0)
+            edges = 1;
+        else if (strcmp(argv[1], "-s") == 0 && argc > 2) {
+            soft = atoi(argv[2]);
+            --argc, ++argv;
+        } else if (strcmp(argv[1], "-m") == 0 && argc > 2) {
+            margin = atoi(argv[2]);
+            --argc, ++argv;
+        } else if (strcmp(argv[1], "-j") == 0 && argc > 2) {
+            nthreads = atoi(argv[2]);
+            batch = 1;
+            --argc, ++argv;
+        } else if (strcmp(argv[1], "-l") == 0 && argc > 2) {
+            if (read_list(argv[2]) < 0) exit(1);
+            batch = 1;
+            --argc, ++argv;
+        } else
+            break;
+    }
+
+    for ( ; argc > 1; --argc, ++argv) {
+        if (add_job(argv[1]) < 0) {
+          fprintf(stderr, "%s: out of memory\n", myname);
+          exit(1);
+        }
+    }
+
+    if (numjobs == 0 && !batch) {
+      fprintf(stderr, "usage: %s [-d] [-c] [-e] [-rs] [-t] [-s n] [-m n] [-j threads] [-l listfile] file...\n",
+              myname);
+      exit(1);
+    }
+
+    /* a single file is decoded straight to the standard output */
+    if (numjobs == 1 && !batch) {
+      ctx = malloc(sizeof(PDF417_CTX));
+      if (ctx == NULL) {
+        fprintf(stderr, "%s: out of memory\n", myname);
+        exit(1);
+      }
+      ctx_init(ctx);
+      if (decode_file(ctx, jobs[0].path, stdout) < 0) exit(1);
+      pdf417_delete(ctx);
+      return 0;
+    }
+
+    if (numjobs == 0) return 0;
+
+    if (nthreads <= 0) nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nthreads <= 0) nthreads = 1;
+
+    return (run_batch(nthreads) < 0) ? 1 : 0;
+}
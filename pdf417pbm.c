@@ -0,0 +1,232 @@
+/* pdf417pbm.c
+
+   Reader for PBM (portable bitmap) files, plain (P1) and raw (P4).
+   Rows are returned packed, in the PDF417_IMAGE bit order (which is the
+   P4 one), so raw files are read with no conversion at all.
+
+   Raw files can also be mapped into memory with pbm_mapimage(); the
+   image then points straight into the mapped file, and the decoder
+   works on the file bits with no read, copy or unpack step.
+
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pdf417pbm.h"
+#include "pdf417types.h"
+
+
+/* the header and plain rows are read either from a stream or from memory */
+
+typedef struct pbm_src {
+    FILE *file;
+    const unsigned char *buf;
+    size_t len, pos;
+} PBM_SRC;
+
+
+static int src_getc(PBM_SRC *src) {
+    if (src->file) return getc(src->file);
+    return (src->pos < src->len) ? src->buf[src->pos++] : EOF;
+}
+
+
+/* read a character, skipping comments */
+
+static int pbm_getc(PBM_SRC *src) {
+    int ch;
+
+    ch = src_getc(src);
+    if (ch == '#') {
+	do {
+	    ch = src_getc(src);
+	} while (ch != EOF && ch != '\n' && ch != '\r');
+    }
+    return ch;
+}
+
+
+/* read an unsigned decimal number, returns -1 on error */
+
+static int pbm_getint(PBM_SRC *src) {
+    int ch, n;
+
+    do {
+	ch = pbm_getc(src);
+    } while (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r');
+
+    if (ch < '0' || ch > '9') return -1;
+
+    n = 0;
+    do {
+	if (n > (0x7fffffff - 9) / 10) return -1;
+	n = n * 10 + ch - '0';
+	ch = pbm_getc(src);
+    } while (ch >= '0' && ch <= '9');
+
+    /* the character following the number has been consumed; after the
+       height, that is the single whitespace that ends the header */
+    return n;
+}
+
+
+static int pbm_parseheader(PBM_SRC *src, int *cols, int *rows, int *format) {
+    int c1, c2;
+
+    c1 = src_getc(src);
+    c2 = src_getc(src);
+    *format = c1 * 256 + c2;
+    if (*format != PBM_FORMAT && *format != RPBM_FORMAT) return -1;
+
+    *cols = pbm_getint(src);
+    *rows = pbm_getint(src);
+    if (*cols <= 0 || *cols > PDF417_MAX_WIDTH || *rows <= 0) return -1;
+
+    return 0;
+}
+
+
+int pbm_readheader(FILE *file, int *cols, int *rows, int *format) {
+    PBM_SRC src;
+
+    memset(&src, 0, sizeof(src));
+    src.file = file;
+
+    return pbm_parseheader(&src, cols, rows, format);
+}
+
+
+/* read one row into a packed row buffer of at least (cols+7)/8 bytes */
+
+int pbm_readrow(FILE *file, unsigned char *row, int cols, int format) {
+    int nbytes = (cols + 7) / 8;
+    int j, ch;
+    PBM_SRC src;
+
+    if (format == RPBM_FORMAT) {
+	if (fread(row, 1, nbytes, file) != (size_t) nbytes) return -1;
+	if (cols & 7) row[nbytes-1] &= 0xff00 >> (cols & 7);
+	return 0;
+    }
+
+    memset(&src, 0, sizeof(src));
+    src.file = file;
+
+    memset(row, 0, nbytes);
+    for (j = 0; j < cols; ++j) {
+	do {
+	    ch = pbm_getc(&src);
+	} while (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r');
+
+	if (ch == '1')
+	    row[j >> 3] |= 0x80 >> (j & 7);
+	else if (ch != '0')
+	    return -1;
+    }
+    return 0;
+}
+
+
+/*
+ *  Scan a PBM stream a row at a time, without reading the whole image:
+ *  only the current and the previous rows are kept in memory, and the
+ *  rows after the symbol can be decoded are not read at all. Returns a
+ *  PDF417_* status code.
+ */
+
+int pbm_scan(FILE *file, PDF417_CTX *ctx) {
+    int cols, rows, format;
+    int i, err;
+    size_t rowsize;
+    UInt64 *buf;
+
+    if (pbm_readheader(file, &cols, &rows, &format) < 0) return PDF417_ERR_ARGS;
+
+    /* two rows, padded to whole words */
+    rowsize = ((size_t) cols + 63) / 64;
+    buf = malloc(2 * rowsize * sizeof(UInt64));
+    if (buf == NULL) return PDF417_ERR_NOMEM;
+
+    err = pdf417_scan_begin(ctx, cols);
+
+    for (i = 0; i < rows && err == PDF417_OK; ++i) {
+	unsigned char *row = (unsigned char *) (buf + (i & 1) * rowsize);
+
+	if (pbm_readrow(file, row, cols, format) < 0) {
+	    err = PDF417_ERR_ARGS;
+	    break;
+	}
+	err = pdf417_scan_row(ctx, row);
+    }
+    if (err >= 0) err = pdf417_scan_end(ctx);
+
+    free(buf);
+    return err;
+}
+
+
+/*
+ *  Map a raw PBM file into memory and set up img to use the file rows
+ *  in place. Returns PBM_NOMAP if the file cannot be mapped (it is not
+ *  a regular file, or not a raw PBM), in which case it should be read
+ *  with pbm_scan(), or a PDF417_* status code.
+ */
+
+int pbm_mapimage(const char *path, PDF417_IMAGE *img, PBM_MAP *map) {
+    struct stat st;
+    PBM_SRC src;
+    int fd, cols, rows, format;
+    size_t size;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return PBM_NOMAP;
+
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size < 8) {
+	close(fd);
+	return PBM_NOMAP;
+    }
+
+    map->len = st.st_size;
+    map->addr = mmap(NULL, map->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map->addr == MAP_FAILED) return PBM_NOMAP;
+
+    memset(&src, 0, sizeof(src));
+    src.buf = map->addr;
+    src.len = map->len;
+
+    if (pbm_parseheader(&src, &cols, &rows, &format) < 0 ||
+        format != RPBM_FORMAT) {
+	pbm_unmap(map);
+	return PBM_NOMAP;
+    }
+
+    /* make sure the whole raster is there */
+    size = (size_t) ((cols + 7) / 8) * rows;
+    if (src.pos > map->len || map->len - src.pos < size) {
+	pbm_unmap(map);
+	return PDF417_ERR_ARGS;
+    }
+
+    madvise(map->addr, map->len, MADV_SEQUENTIAL);
+
+    img->cols = cols;
+    img->rows = rows;
+    img->stride = (cols + 7) / 8;
+    img->bits = (const unsigned char *) map->addr + src.pos;
+    img->mem = NULL;
+
+    return PDF417_OK;
+}
+
+
+void pbm_unmap(PBM_MAP *map) {
+    if (map->addr != NULL && map->addr != MAP_FAILED) munmap(map->addr, map->len);
+    map->addr = NULL;
+}
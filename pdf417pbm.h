@@ -0,0 +1,39 @@
+/* pdf417pbm.h
+
+   Reader for PBM (portable bitmap) files, plain (P1) and raw (P4).
+
+*/
+
+#ifndef _PDF417PBM_H_
+#define _PDF417PBM_H_
+
+#include <stdio.h>
+#include "pdf417decode.h"
+
+/* Magic constants. */
+
+#define PBM_MAGIC1 'P'
+#define PBM_MAGIC2 '1'
+#define RPBM_MAGIC2 '4'
+#define PBM_FORMAT (PBM_MAGIC1 * 256 + PBM_MAGIC2)
+#define RPBM_FORMAT (PBM_MAGIC1 * 256 + RPBM_MAGIC2)
+
+/* pbm_mapimage() result when the file has to be read instead */
+
+#define PBM_NOMAP 1
+
+/* a raw PBM file mapped into memory */
+
+typedef struct pbm_map {
+    void *addr;
+    size_t len;
+} PBM_MAP;
+
+int pbm_readheader(FILE *file, int *cols, int *rows, int *format);
+int pbm_readrow(FILE *file, unsigned char *row, int cols, int format);
+int pbm_scan(FILE *file, PDF417_CTX *ctx);
+
+int pbm_mapimage(const char *path, PDF417_IMAGE *img, PBM_MAP *map);
+void pbm_unmap(PBM_MAP *map);
+
+#endif /*_PDF417PBM_H_*/
@@ -1,206 +1,429 @@
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <errno.h>
+#include "pdf417rs.h"
+#include "pdf417_gf.h"
+#include "pdf417simd.h"
 
-#define NN	1024
-#define PRIM	1
 #define GPRIME	929
-#define KK	32
-#define A0	928
-#define Ldec	1
 
-#ifndef FALSE
-#define FALSE	0
-#endif
-#ifndef TRUE
-#define TRUE	1
+/*
+ * Arithmetic in GF(929), on elements in polynomial form, i.e. integers
+ * in [0, 929), with the read-only tables of pdf417_gf.c. Sums and
+ * differences need at most one correction, and the logarithms are under
+ * 928 with the powers of 3 stored twice over, so no divisions are needed.
+ */
+
+static int gf_add(int a, int b) {
+    a += b;
+    return (a >= GPRIME) ? a - GPRIME : a;
+}
+
+
+static int gf_sub(int a, int b) {
+    a -= b;
+    return (a < 0) ? a + GPRIME : a;
+}
+
+
+static int gf_mul(int a, int b) {
+    if (a == 0 || b == 0) return 0;
+    return gf929_exp[gf929_log[a] + gf929_log[b]];
+}
+
+
+/* multiply a by 3**e, 0 <= e <= 928 */
+
+static int gf_mul_exp(int a, int e) {
+    if (a == 0) return 0;
+    return gf929_exp[gf929_log[a] + e];
+}
+
+
+/* 3**(-e) for 0 <= e <= 928 */
+
+static int gf_exp_neg(int e) {
+    return gf929_exp[GPRIME - 1 - e];
+}
+
+
+/* evaluate poly[0] + poly[1] x + ... + poly[deg] x^deg */
+
+static int gf_eval(const int *poly, int deg, int x) {
+    int i, v = 0;
+
+    for (i = deg; i >= 0; i--) v = gf_add(gf_mul(v, x), poly[i]);
+    return v;
+}
+
+
+/*
+ * Form the syndromes of data[], i.e. evaluate data(x) at the roots of
+ * g(x), namely 3**i, i = 1, ... , synd_len, into synd[1] ... synd[synd_len].
+ * data[p] is the coefficient of x^(data_len-p), so the locator of
+ * position p is 3^(data_len-p). The values must be valid (under 929).
+ */
+
+static void rs_syndromes_generic(const int data[], int data_len, int synd_len, int synd[])
+{
+    int i, j, e, step;
+
+    for (i = 1; i <= synd_len; i++) {
+	synd[i] = 0;
+    }
+
+    for (j = 1; j <= data_len; j++) {
+
+	if (data[data_len - j] == 0) continue;
+
+	/* the term of synd[i] is 3^(log(data) + i*j), stepped by j */
+	e = gf929_log[data[data_len - j]];
+	step = (j < GPRIME - 1) ? j : j - (GPRIME - 1);
+
+	for (i = 1; i <= synd_len; i++) {
+	    e += step;
+	    if (e >= GPRIME - 1) e -= GPRIME - 1;
+	    synd[i] = gf_add(synd[i], gf929_exp[e]);
+	}
+    }
+}
+
+
+#ifdef PDF417_X86_SIMD
+
+/*
+ * AVX2 version: synd[i] = data(3^i) by Horner's rule, for 8 values of i
+ * in the 32-bit lanes of a vector, and 4 vectors at a time to hide the
+ * latency of the multiplies. The products (under 929^2) are reduced by
+ * Barrett reduction with m = 2^21 / 929 rounded down, which leaves the
+ * quotient at most 2 short; two conditional subtracts make up for it.
+ */
+
+#define BARRETT_SHIFT  21
+#define BARRETT_M      ((1 << BARRETT_SHIFT) / GPRIME)
+#define SYND_VECS      4
+
+/* x - p if that is not negative, else x, for x under 2^31 */
+
+TARGET("avx2")
+static ALWAYS_INLINE __m256i gf_csub8(__m256i x, __m256i p) {
+    return _mm256_min_epu32(x, _mm256_sub_epi32(x, p));
+}
+
+
+/* (s + d) * a mod 929, for s, d and a under 929 */
+
+TARGET("avx2")
+static ALWAYS_INLINE __m256i gf_horner8(__m256i s, __m256i d, __m256i a,
+					__m256i m, __m256i p) {
+    __m256i x, q;
+
+    x = _mm256_mullo_epi32(gf_csub8(_mm256_add_epi32(s, d), p), a);
+    q = _mm256_srli_epi32(_mm256_mullo_epi32(x, m), BARRETT_SHIFT);
+    x = _mm256_sub_epi32(x, _mm256_mullo_epi32(q, p));
+    return gf_csub8(gf_csub8(x, p), p);
+}
+
+
+TARGET("avx2")
+static void rs_syndromes_avx2(const int data[], int data_len, int synd_len, int synd[])
+{
+    const __m256i p = _mm256_set1_epi32(GPRIME);
+    const __m256i m = _mm256_set1_epi32(BARRETT_M);
+    int pw[8 * SYND_VECS], out[8 * SYND_VECS];
+    int i, j, k, n;
+
+    for (i = 0; i < synd_len; i += 8 * SYND_VECS) {
+	__m256i a[SYND_VECS], s[SYND_VECS], d;
+
+	/* the lanes past synd_len are computed, but not stored */
+	for (k = 0; k < 8 * SYND_VECS; k++) {
+	    pw[k] = gf929_exp[i + k + 1];
+	}
+	for (k = 0; k < SYND_VECS; k++) {
+	    a[k] = _mm256_loadu_si256((const __m256i *) (pw + 8 * k));
+	    s[k] = _mm256_setzero_si256();
+	}
+
+	for (j = 0; j < data_len; j++) {
+	    d = _mm256_set1_epi32(data[j]);
+	    for (k = 0; k < SYND_VECS; k++) {
+		s[k] = gf_horner8(s[k], d, a[k], m, p);
+	    }
+	}
+
+	for (k = 0; k < SYND_VECS; k++) {
+	    _mm256_storeu_si256((__m256i *) (out + 8 * k), s[k]);
+	}
+	n = (synd_len - i < 8 * SYND_VECS) ? synd_len - i : 8 * SYND_VECS;
+	memcpy(synd + i + 1, out, n * sizeof(int));
+    }
+}
+
 #endif
 
-int Alpha_to[1024];
-int Index_of[1024];
 
-static int rs_init = FALSE;
+/*
+ * Chien search: find the roots of lambda(x), of degree deg, among the
+ * inverse locators 3^-(data_len-p) of the data_len positions, the only
+ * ones that can be in error, writing the positions p to loc[]. Stops
+ * after deg roots; returns how many were found.
+ */
 
+static int chien_generic(const int *lambda, int deg, int data_len, int *loc)
+{
+    int i, count = 0;
 
-// initialize table of 3**i for syndrome calculation
+    for (i = 0; i < data_len && count < deg; i++) {
+	if (gf_eval(lambda, deg, gf_exp_neg(data_len - i)) == 0) {
+	    loc[count++] = i;
+	}
+    }
+    return count;
+}
 
-void powers_init() {
-    int ii;
-    int power_of_3;
-    int debug;
 
-    debug = 0;
-    power_of_3 = 1;
-    Index_of[1] = GPRIME - 1;
+#ifdef PDF417_X86_SIMD
 
-    for (ii = 0; ii < GPRIME - 1; ii += 1) {
-	Alpha_to[ii] = power_of_3;
-	if (power_of_3 < GPRIME) {
-	    if (ii != GPRIME - 1) Index_of[power_of_3] = ii;
-	} else {
-	    printf("Internal error: powers of 3 calculation\n");
+/*
+ * AVX2 version: lambda is evaluated by Horner's rule at the points of
+ * 8 positions per vector, 4 vectors at a time, as for the syndromes.
+ * The points past data_len (at most 31) are evaluated, but not used.
+ */
+
+TARGET("avx2")
+static int chien_avx2(const int *lambda, int deg, int data_len, int *loc)
+{
+    const __m256i p = _mm256_set1_epi32(GPRIME);
+    const __m256i m = _mm256_set1_epi32(BARRETT_M);
+    const __m256i zero = _mm256_setzero_si256();
+    int pt[8 * SYND_VECS];
+    int i, j, k, count = 0;
+    unsigned int roots;
+
+    for (i = 0; i < data_len && count < deg; i += 8 * SYND_VECS) {
+	__m256i x[SYND_VECS], v[SYND_VECS], c;
+
+	for (k = 0; k < 8 * SYND_VECS; k++) {
+	    pt[k] = gf929_exp[GPRIME - 1 - data_len + i + k];
+	}
+	for (k = 0; k < SYND_VECS; k++) {
+	    x[k] = _mm256_loadu_si256((const __m256i *) (pt + 8 * k));
+	    v[k] = zero;
 	}
 
-	if (debug) {
-	    printf("pow = %d  ii = %d \n", power_of_3, ii);
+	/* v = (...(lambda[deg] x + lambda[deg-1]) x + ... + lambda[1]) x */
+	for (j = deg; j > 0; j--) {
+	    c = _mm256_set1_epi32(lambda[j]);
+	    for (k = 0; k < SYND_VECS; k++) {
+		v[k] = gf_horner8(v[k], c, x[k], m, p);
+	    }
 	}
-	if (debug) {
-	    printf("log = %d \n", ii);
+
+	/* v + lambda[0] == 0 */
+	c = _mm256_set1_epi32(gf_sub(0, lambda[0]));
+	for (k = 0; k < SYND_VECS; k++) {
+	    roots = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v[k], c)));
+	    for (j = i + 8 * k; roots != 0; j++, roots >>= 1) {
+		if ((roots & 1) && j < data_len && count < deg) loc[count++] = j;
+	    }
 	}
-	power_of_3 = (power_of_3 * 3) % GPRIME;
     }
-    Index_of[0] = GPRIME - 1;
-    Alpha_to[GPRIME - 1] = 1;
-    Index_of[GPRIME] = A0;
+    return count;
+}
+
+#endif
+
+
+static void (*rs_syndromes_fn)(const int [], int, int, int []) = rs_syndromes_generic;
+static int (*chien_fn)(const int *, int, int, int *) = chien_generic;
+
+#ifdef PDF417_X86_SIMD
+
+/* pick the kernels for this CPU, before any thread is started */
+
+STARTUP static void rs_cpu_init(void) {
+    CPU_INIT();
+    if (CPU_SUPPORTS("avx2")) {
+	rs_syndromes_fn = rs_syndromes_avx2;
+	chien_fn = chien_avx2;
+    }
+}
+
+#endif
+
+
+void rs_syndromes(const int data[], int data_len, int synd_len, int synd[])
+{
+    rs_syndromes_fn(data, data_len, synd_len, synd);
+}
+
+
+/*
+ * Update the syndromes of a block of data_len symbols for a change of
+ * delta (mod 929) in the symbol at position pos, so they can be kept up
+ * to date as the symbols arrive or change, one at a time.
+ */
+
+void rs_syndromes_add(int synd[], int synd_len, int data_len, int pos, int delta)
+{
+    int i, e, step;
+
+    delta %= GPRIME;
+    if (delta < 0) delta += GPRIME;
+    if (delta == 0) return;
+
+    e = gf929_log[delta];
+    step = data_len - pos;
+    if (step >= GPRIME - 1) step -= GPRIME - 1;
+    for (i = 1; i <= synd_len; i++) {
+	e += step;
+	if (e >= GPRIME - 1) e -= GPRIME - 1;
+	synd[i] = gf_add(synd[i], gf929_exp[e]);
+    }
+}
+
+
+/*
+ * The workspace holds the syndromes for eras_dec_rs(), lambda, b, t and
+ * omega, each synd_len + 1 long, and loc and err, each synd_len long.
+ */
+
+#define WORK_INTS(synd_len)  (7 * (synd_len) + 5)
+
+static int *work_get(RS_WORK *work, int synd_len)
+{
+    if (work->synd_len < synd_len) {
+	free(work->buf);
+	work->buf = malloc(WORK_INTS(synd_len) * sizeof(int));
+	work->synd_len = (work->buf != NULL) ? synd_len : 0;
+    }
+    return work->buf;
+}
+
+
+void rs_work_free(RS_WORK *work)
+{
+    free(work->buf);
+    work->buf = NULL;
+    work->synd_len = 0;
 }
 
 
-#define modbase(x) ((x) % (GPRIME - 1))
+static int check_input(const int data[], const int eras_pos[],
+		       int no_eras, int data_len, int synd_len)
+{
+    int i;
+
+    if (synd_len <= 0 || synd_len > data_len || data_len > GPRIME - 1) return -1;
+    if (no_eras < 0 || no_eras > synd_len) return -1;
+
+    for (i = 0; i < data_len; i++)
+	if (data[i] < 0 || data[i] >= GPRIME)
+	    return -1;
+
+    for (i = 0; i < no_eras; i++)
+	if (eras_pos[i] < 0 || eras_pos[i] >= data_len)
+	    return -1;
+
+    return 0;
+}
+
 
 /*
  * Performs ERRORS+ERASURES decoding of RS codes. If decoding is successful,
  * writes the codeword into data[] itself. Otherwise data[] is unaltered.
  *
+ * The last synd_len of the data_len symbols in data[] are the check
+ * symbols. The syndromes are those of rs_syndromes().
+ *
  * Return number of symbols corrected, or -1 if codeword is illegal
- * or uncorrectable. If eras_pos is non-null, the detected error locations
- * are written back. NOTE! This array must be at least NN-KK elements long.
- * 
- * First "no_eras" erasures are declared by the calling program. Then, the
- * maximum # of errors correctable is t_after_eras = floor((NN-KK-no_eras)/2).
- * If the number of channel errors is not greater than "t_after_eras" the
- * transmitted codeword will be recovered. Details of algorithm can be found
- * in R. Blahut's "Theory ... of Error-Correcting Codes".
+ * or uncorrectable (RS_ERR_NOMEM if the workspace could not be grown).
+ * If eras_pos is non-null, the positions (indices in data[]) corrected
+ * are written back. NOTE! This array must be at least synd_len elements
+ * long.
+ *
+ * First "no_eras" erasures are declared by the calling program, as indices
+ * in data[]. Then, the maximum # of errors correctable is
+ * t_after_eras = floor((synd_len-no_eras)/2). If the number of channel
+ * errors is not greater than "t_after_eras" the transmitted codeword will
+ * be recovered. Details of algorithm can be found in R. Blahut's "Theory
+ * ... of Error-Correcting Codes".
  *
  * Warning: the eras_pos[] array must not contain duplicate entries; decoder failure
  * will result. The decoder *could* check for this condition, but it would involve
  * extra time on every decoding operation.
  */
 
-int eras_dec_rs(int data[NN], int eras_pos[NN - KK], int no_eras,
-		int data_len, int synd_len)
+int eras_dec_rs(RS_WORK *work, int data[], int eras_pos[],
+		int no_eras, int data_len, int synd_len)
 {
-    int deg_lambda, el, deg_omega;
-    int i, j, r, k;
-    int u, q, tmp, num1, num2, den, discr_r;
-    int lambda[2048 + 1], s[2048 + 1];	/* Err+Eras Locator poly
-					 * and syndrome poly */
-    int b[2048 + 1], t[2048 + 1], omega[2048 + 1];
-    int root[2048], reg[2048 + 1], loc[2048];
-    int syn_error, count;
-    int ci;
-    int error_val;
-    int fix_loc;
-    int debug;
-
-    if (!rs_init) powers_init();
-
-    debug = 0;
+    int *s;
 
-#define DEBUG 2
+    if (check_input(data, eras_pos, no_eras, data_len, synd_len) < 0) return -1;
+    if ((s = work_get(work, synd_len)) == NULL) return RS_ERR_NOMEM;
 
-#if DEBUG >= 1 && MM != 8
+    rs_syndromes(data, data_len, synd_len, s);
 
-    /* Check for illegal input values */
-    for (i = 0; i < data_len; i++)
-	if (data[i] > GPRIME)
-	    return -1;
-#endif
-
-    /* form the syndromes; i.e. evaluate data(x) at roots of g(x)
-       namely @**(1+i)*PRIM, i = 0, ... , (NN-KK-1) */
-    for (i = 1; i <= synd_len; i++) {
-	s[i] = 0;//data[data_len];
-    }
+    return eras_dec_rs_synd(work, data, s, eras_pos, no_eras, data_len, synd_len);
+}
 
-    for (j = 1; j <= data_len; j++) {
 
-	if (data[data_len - j] == 0) continue;
+/*
+ * The same as eras_dec_rs(), with the syndromes of data[] already formed
+ * in synd[1] ... synd[synd_len] (kept up to date with rs_syndromes_add(),
+ * for instance).
+ */
 
-	tmp = Index_of[data[data_len - j]];
+int eras_dec_rs_synd(RS_WORK *work, int data[], const int synd[], int eras_pos[],
+		     int no_eras, int data_len, int synd_len)
+{
+    int deg_lambda, el, deg_omega;
+    int i, j, r;
+    int x, tmp, num1, den, discr_r;
+    const int *s = synd;	/* syndrome poly */
+    int *lambda;		/* Err+Eras Locator poly */
+    int *b, *t, *omega;
+    int *loc, *err;
+    int syn_error, count;
 
-	/*  s[i] ^= Alpha_to[modbase(tmp + (1+i-1)*j)]; */
-	for (i = 1; i <= synd_len; i++) {
-	    s[i] = (s[i] + Alpha_to[modbase(tmp + (i) * j)]) % GPRIME;
-	}
-    }
+    /* Check for illegal input values */
+    if (check_input(data, eras_pos, no_eras, data_len, synd_len) < 0) return -1;
 
-    /* Convert syndromes to index form, checking for nonzero condition */
     syn_error = 0;
     for (i = 1; i <= synd_len; i++) {
 	syn_error |= s[i];
-	if (debug) {
-	    printf("Raw syndrome = %d i = %d \n", s[i], i);
-	}
-	s[i] = Index_of[s[i]];
     }
 
     if (!syn_error) {
 	/* if syndrome is zero, data[] is a codeword and there are no
 	 * errors to correct. So return data[] unmodified
 	 */
-	count = 0;
-	printf("No errors \n");
-	goto finish;
+	return 0;
     }
 
-    for (ci = synd_len - 1; ci >= 0; ci--) lambda[ci + 1] = 0;
-
+    /* past the syndromes of eras_dec_rs(), which may be in the workspace */
+    if (work_get(work, synd_len) == NULL) return RS_ERR_NOMEM;
+    lambda = work->buf + synd_len + 1;
+    b = lambda + synd_len + 1;
+    t = b + synd_len + 1;
+    omega = t + synd_len + 1;
+    loc = omega + synd_len + 1;
+    err = loc + synd_len;
+
+    /* Init lambda to be the erasure locator polynomial,
+       the product of (1 - X x) over the erasure locators X */
+    memset(lambda, 0, (synd_len + 1) * sizeof(int));
     lambda[0] = 1;
 
-    if (no_eras > 0) {
-	/* Init lambda to be the erasure locator polynomial */
-	lambda[1] = Alpha_to[modbase(PRIM * eras_pos[0])];
-	for (i = 1; i < no_eras; i++) {
-	    u = modbase(PRIM * eras_pos[i]);
-	    for (j = i + 1; j > 0; j--) {
-		tmp = Index_of[lambda[j - 1]];
-		if (tmp != A0)
-		    lambda[j] = (lambda[j] + Alpha_to[modbase(u + tmp)]) % GPRIME;
-	    }
-	}
-#if DEBUG >= 1
-	/* Test code that verifies the erasure locator polynomial just constructed
-	   Needed only for decoder debugging. */
-
-	/* find roots of the erasure location polynomial */
-	for (i = 1; i <= no_eras; i++)
-	    reg[i] = Index_of[lambda[i]];
-	count = 0;		// usg NN = GPRIME-1?
-
-	for (i = 1, k = data_len - Ldec; i <= data_len + synd_len;
-	     i++, k = modbase(data_len + k - Ldec)) {
-	    q = 1;
-	    for (j = 1; j <= no_eras; j++)
-		if (reg[j] != A0) {
-		    reg[j] = modbase(reg[j] + j);
-		    q = (q + Alpha_to[reg[j]]) % GPRIME;
-		}
-	    if (q != 0)
-		continue;
-	    /* store root and error location number indices */
-	    root[count] = i;
-	    loc[count] = k;
-	    count++;
+    for (i = 0; i < no_eras; i++) {
+	x = data_len - eras_pos[i];	/* log of the locator */
+	for (j = i + 1; j > 0; j--) {
+	    lambda[j] = gf_sub(lambda[j], gf_mul_exp(lambda[j - 1], x));
 	}
-	if (count != no_eras) {
-	    // printf("\n lambda(x) is WRONG\n");
-	    // count = -1;
-	    //  goto finish;
-	}
-#if DEBUG >= 2
-	printf
-	    ("\n Erasure positions as determined by roots of Eras Loc Poly:\n");
-	for (i = 0; i < count; i++)
-	    printf("loc  = %d ", loc[i]);
-	printf("\n");
-#endif
-#endif
     }
-    for (i = 0; i < synd_len + 1; i++)
-	b[i] = Index_of[lambda[i]];
+
+    for (i = 0; i <= synd_len; i++)
+	b[i] = lambda[i];
 
     /*
      * Begin Berlekamp-Massey algorithm to determine error+erasure
@@ -212,322 +435,105 @@ int eras_dec_rs(int data[NN], int eras_pos[NN - KK], int no_eras,
 	/* Compute discrepancy at the r-th step in poly-form */
 	discr_r = 0;
 	for (i = 0; i < r; i++) {
-	    if ((lambda[i] != 0) && (s[r - i] != A0)) {
-		if (debug) {
-		    printf("do add Index_of[lambda[]] = %d \n",
-			   Index_of[lambda[i]]);
-		}
-		if (i % 2 == 1) {
-		    discr_r = (discr_r + Alpha_to[modbase((Index_of[lambda[i]] + s[r - i]))]) % GPRIME;
-		} else {
-		    discr_r = (discr_r + GPRIME - Alpha_to[modbase((Index_of[lambda[i]] + s[r - i]))]) % GPRIME;
-		}
-		if (debug) {
-		    printf("In loop - discr = %d i = %d r = %d lambda[i] = %d s[r-i] = %d \n",
-			   discr_r, i, r, lambda[i], s[r - i]);
-		}
-	    }
+	    discr_r = gf_add(discr_r, gf_mul(lambda[i], s[r - i]));
 	}
-	if (debug) {
-	    printf("r = %d Discrepency = %d \n", r, discr_r);
-	}
-
-	discr_r = Index_of[discr_r];	/* Index form */
 
-	if (discr_r == A0) {
+	if (discr_r == 0) {
 	    /* 2 lines below: B(x) <-- x*B(x) */
-	    //  COPYDOWN(&b[1],b,synd_len);
-	    //
-	    if (debug) {
-		printf("Discrepancy = A0\n");
-	    }
-	    for (ci = synd_len - 1; ci >= 0; ci--) b[ci + 1] = b[ci];
-	    b[0] = A0;
+	    for (i = synd_len; i > 0; i--) b[i] = b[i - 1];
+	    b[0] = 0;
 	} else {
 	    /* 7 lines below: T(x) <-- lambda(x) - discr_r*x*b(x) */
-	    /*  the T(x) will become the next lambda */
-
 	    t[0] = lambda[0];
 	    for (i = 0; i < synd_len; i++) {
-		if (debug) {
-		    printf("i = %d b[i] = %d \n", i, b[i]);
-		}
-		if (b[i] != A0) {
-
-		    //  t[i+1] =  (lambda[i+1] + GPRIME -
-		    //              Alpha_to[modbase(discr_r + GPRIME - 1 -  b[i])]) % GPRIME;
-		    t[i + 1] = (lambda[i + 1] + Alpha_to[modbase(discr_r + b[i])]) % GPRIME;
-
-		    if (debug) {
-			printf("New t[i+1] = %d lambda[i+1] = %d b[i] = %d i = %d discr_r = %d\n",
-			       t[i + 1], lambda[i + 1], b[i], i, discr_r);
-		    }
-		} else {
-		    t[i + 1] = lambda[i + 1];
-		}
-		if (debug) {
-		    printf("i = %d t[i+1] = %d lambda[i+1] = %d \n", i,
-			   t[i + 1], lambda[i + 1]);
-		}
+		t[i + 1] = gf_sub(lambda[i + 1], gf_mul(discr_r, b[i]));
 	    }
-	    el = 0;
+
 	    if (2 * el <= r + no_eras - 1) {
-		if (debug) {
-		    printf("Reached the el stuff, inv  el = %d r = %d \n", el, r);
-		}
 		el = r + no_eras - el;
 		/*
 		 * 2 lines below: B(x) <-- inv(discr_r) *
 		 * lambda(x)
 		 */
+		tmp = gf929_inv[discr_r];
 		for (i = 0; i <= synd_len; i++) {
-
-		    if (lambda[i] == 0) {
-			b[i] = A0;
-		    } else {
-			b[i] = modbase(Index_of[lambda[i]] - discr_r + GPRIME - 1);
-			if (debug) {
-			    printf("Inverting le  b[i] = %d i = %d \n", b[i], i);
-			}
-		    }
+		    b[i] = gf_mul(tmp, lambda[i]);
 		}
-
 	    } else {
-		if (debug) {
-		    printf("Reached the el stuff, x mul,   el = %d r = %d \n", el, r);
-		}
 		/* 2 lines below: B(x) <-- x*B(x) */
-		//      COPYDOWN(&b[1],b,synd_len);
-		for (ci = synd_len - 1; ci >= 0; ci--) b[ci + 1] = b[ci];
-		b[0] = A0;
+		for (i = synd_len; i > 0; i--) b[i] = b[i - 1];
+		b[0] = 0;
 	    }
-	    //      COPY(lambda,t,synd_len+1);
 
-	    for (ci = synd_len + 1 - 1; ci >= 0; ci--) {
-		lambda[ci] = t[ci];
-		if (debug) {
-		    printf("ci = %d Lambda = %d \n", ci, t[ci]);
-		}
+	    for (i = 0; i <= synd_len; i++) {
+		lambda[i] = t[i];
 	    }
 	}
     }
 
-    /* Convert lambda to index form and compute deg(lambda(x)) */
+    /* compute deg(lambda(x)); more errors than can be corrected? */
     deg_lambda = 0;
-    for (i = 0; i < synd_len + 1; i++) {
-
-	lambda[i] = Index_of[lambda[i]];
-
-	if (lambda[i] != A0) deg_lambda = i;
-
-	if (debug) {
-	    printf("Lambda in index form = %d \n", lambda[i]);
-	}
-
-    }
-
-    if (debug) {
-	printf("Determination of deg_lambda = %d \n", deg_lambda);
+    for (i = 0; i <= synd_len; i++) {
+	if (lambda[i] != 0) deg_lambda = i;
     }
+    if (deg_lambda != el || 2 * el - no_eras > synd_len) return -1;
 
     /*
      * Find roots of the error+erasure locator polynomial by Chien
-     * Search
+     * Search: position p is in error if lambda(inv(X)) = 0, with
+     * X = 3^(data_len-p) its locator. count is the number of roots.
      */
-
-    for (ci = synd_len - 1; ci >= 0; ci--)
-	reg[ci + 1] = lambda[ci + 1];
-
-    count = 0;			/* Number of roots of lambda(x) */
-    for (i = 1, k = data_len - 1; i <= GPRIME; i++) {
-	q = 1;
-	if (debug) {
-	    printf(" Reg[j] = %d q = %d i = %d \n", reg[j], q, i);
-	}
-	for (j = deg_lambda; j > 0; j--) {
-
-	    if (reg[j] != A0) {
-		if (debug) {
-		    printf("loop Reg[j] pre = %d \n", reg[j]);
-		}
-		reg[j] = modbase(reg[j] + j);
-		//      q = modbase( q +  Alpha_to[reg[j]]);
-		if (deg_lambda != 1) {
-		    if (j % 2 == 0) {
-			q = (q + Alpha_to[reg[j]]) % GPRIME;
-		    } else {
-			q = (q + GPRIME - Alpha_to[reg[j]]) % GPRIME;
-		    }
-		} else {
-		    q = Alpha_to[reg[j]] % GPRIME;
-		    if (q == 1) --q;
-		}
-		if (debug) {
-		    printf("loop Reg[j] = %d q = %d i = %d j = %d %d = k\n",
-			   reg[j], q, i, j, k);
-		}
-	    }
-	}
-
-	if (q == 0) {
-	    /* store root (index-form) and error location number */
-	    root[count] = i;
-
-	    loc[count] = GPRIME - 1 - i;
-	    if (count < synd_len) {
-		count += 1;
-	    } else {
-		printf("Error : Error count too big = %d \n", count);
-	    }
-
-	    if (debug) {
-		printf("root  = %d loc = %d \n", i, k);
-	    }
-
-	}
-	if (k == 0) {
-	    k = data_len - 1;
-	} else {
-	    k -= 1;
-	}
-
-	/* If we've already found max possible roots,
-	 * abort the search to save time
-	 */
-
-	if (count == deg_lambda) break;
-
-    }
+    count = chien_fn(lambda, deg_lambda, data_len, loc);
 
     if (deg_lambda != count) {
 	/*
 	 * deg(lambda) unequal to number of roots => uncorrectable
 	 * error detected
 	 */
-
-	printf("Uncorrectable error: root count = %d deg lambda = %d \n",
-	       count, deg_lambda);
-	count = -1;
-	goto finish;
+	return -1;
     }
 
     /*
      * Compute err+eras evaluator poly omega(x) = s(x)*lambda(x) (modulo
-     * x**(synd_len)). in index form. Also find deg(omega).
+     * x**(synd_len)), with s(x) = s[1] + s[2] x + ... Also find deg(omega).
      */
     deg_omega = 0;
     for (i = 0; i < synd_len; i++) {
 	tmp = 0;
 	j = (deg_lambda < i) ? deg_lambda : i;
-	if (debug) {
-	    printf("j = %d deg_lambda = %d lambda[j] = %d \n",
-		   j, deg_lambda, lambda[j]);
-	}
 	for (; j >= 0; j--) {
-	    if ((s[i + 1 - j] != A0) && (lambda[j] != A0)) {
-		if (j % 2 == 1) {
-		    tmp = (tmp + GPRIME - Alpha_to[modbase(s[i + 1 - j] + lambda[j])]) % GPRIME;
-		} else {
-
-		    tmp = (tmp + Alpha_to[modbase(s[i + 1 - j] + lambda[j])]) % GPRIME;
-		}
-		if (debug) {
-		    printf("In tmp loop  tmp = %d i = %d j = %d s[i+1-j] = %d lambda[j] = %d \n",
-			   tmp, i, j, s[i + 1 - j], lambda[j]);
-		}
-	    }
+	    tmp = gf_add(tmp, gf_mul(s[i + 1 - j], lambda[j]));
 	}
-
 	if (tmp != 0) deg_omega = i;
-	omega[i] = Index_of[tmp];
-	if (debug) {
-	    printf("Omega [i] = %d i = %d \n", omega[i], i);
-	}
-
-    }
-    omega[synd_len] = A0;
-    if (debug) {
-	printf("Degree of omega = %d \n", deg_omega);
+	omega[i] = tmp;
     }
 
     /*
-     * Compute error values in poly-form. num1 = omega(inv(X(l))), num2 =
-     * inv(X(l))**(B0-1) and den = lambda_pr(inv(X(l))) all in poly-form
+     * lambda'(x), the formal derivative: in GF(929) the coefficient of
+     * x^(i-1) is i*lambda[i] (mod 929), not just the odd terms.
      */
-    for (j = count - 1; j >= 0; j--) {
-	num1 = 0;
-	for (i = deg_omega; i >= 0; i--) {
-	    if (omega[i] != A0) {
-		//    num1  = ( num1 + Alpha_to[modbase(omega[i] + (i * root[j])]) % GPRIME;
-		num1 = (num1 + Alpha_to[modbase(omega[i] + ((i + 1) * root[j]))]) % GPRIME;
-		if (debug) {
-		    printf("Num1 = %d i = %d omega[i] = %d root[j] = %d \n",
-			   num1, i, omega[i], root[j]);
-		}
-	    }
-	}
-	//  num2 = Alpha_to[modbase(root[j] * (1 - 1) + data_len)];
-
-	num2 = 1;
-	den = 0;
-
-	// denominator if product of all (1 - Bj Bk) for k != j
-	// if count = 1, then den = 1
-
-	den = 1;
-	for (k = 0; k < count; k += 1) {
-	    if (k != j) {
-		tmp = (1 + GPRIME - Alpha_to[modbase(GPRIME - 1 - root[k] + root[j])]) % GPRIME;
-		den = Alpha_to[modbase(Index_of[den] + Index_of[tmp])];
-	    }
-	}
-
-	if (debug) {
-	    printf("den = %d \n", den);
-	}
-
-	if (den == 0) {
-#if DEBUG >= 1
-	    printf("\n ERROR: denominator = 0\n");
-#endif
-	    /* Convert to dual- basis */
-	    count = -1;
-	    goto finish;
-	}
-
-	if (debug) {
-	    printf("Index num1 = %d Index num2 = %d Index of den = %d \n",
-		   Index_of[num1], Index_of[num2], Index_of[den]);
-	}
+    for (i = 1; i <= deg_lambda; i++) {
+	t[i - 1] = gf_mul(i, lambda[i]);
+    }
 
-	error_val = Alpha_to[modbase(Index_of[num1] + Index_of[num2] +
-				     GPRIME - 1 - Index_of[den])] % GPRIME;
+    /*
+     * Compute error values by Forney's algorithm:
+     * Y = -omega(inv(X)) / lambda'(inv(X))
+     */
+    for (j = 0; j < count; j++) {
+	x = gf_exp_neg(data_len - loc[j]);
+	num1 = gf_eval(omega, deg_omega, x);
+	den = gf_eval(t, deg_lambda - 1, x);
 
-	if (debug) {
-	    printf("error_val = %d \n", error_val);
-	}
+	if (den == 0) return -1;
 
-	/* Apply error to data */
-	if (num1 != 0) {
-	    if (loc[j] < data_len + 1) {
-		fix_loc = data_len - loc[j];
-		if (debug) {
-		    printf("Fix loc = %d \n", fix_loc);
-		}
-		if (fix_loc < data_len + 1) {
-		    data[fix_loc] = (data[fix_loc] + GPRIME - error_val) % GPRIME;
-		}
-	    }
-	}
-    }
-  finish:
-    if (debug) {
-	printf("At FINISH \n");
+	err[j] = gf_sub(0, gf_mul(num1, gf929_inv[den]));
     }
-    if (eras_pos != NULL) {
-	for (i = 0; i < count; i++) {
-	    if (eras_pos != NULL) eras_pos[i] = loc[i];
-	}
+
+    /* Apply errors to data */
+    for (j = 0; j < count; j++) {
+	data[loc[j]] = gf_sub(data[loc[j]], err[j]);
+	if (eras_pos != NULL) eras_pos[j] = loc[j];
     }
 
     return count;
@@ -0,0 +1,36 @@
+/* pdf417rs.h
+
+   Reed-Solomon error correction over GF(929) for PDF417 symbols.
+
+*/
+
+#ifndef _PDF417RS_H_
+#define _PDF417RS_H_
+
+/*
+ * Workspace of the decoder, owned by the caller and reused from one call
+ * to the next. It grows to the largest synd_len decoded, so nothing big
+ * is kept on the stack. Zero it before the first use, and release it
+ * with rs_work_free().
+ */
+
+typedef struct rs_work {
+    int *buf;
+    int synd_len;     /* the largest synd_len buf has room for */
+} RS_WORK;
+
+/* returned by the decoder if the workspace could not be allocated */
+
+#define RS_ERR_NOMEM  -2
+
+void rs_work_free(RS_WORK *work);
+
+void rs_syndromes(const int data[], int data_len, int synd_len, int synd[]);
+void rs_syndromes_add(int synd[], int synd_len, int data_len, int pos, int delta);
+
+int eras_dec_rs(RS_WORK *work, int data[], int eras_pos[], int no_eras,
+                int data_len, int synd_len);
+int eras_dec_rs_synd(RS_WORK *work, int data[], const int synd[], int eras_pos[],
+                     int no_eras, int data_len, int synd_len);
+
+#endif /*_PDF417RS_H_*/
@@ -0,0 +1,32 @@
+/* pdf417simd.h
+
+   Support for SIMD kernels selected at run time.
+
+   On x86-64 with gcc (or a compatible compiler), kernels can be compiled
+   for a given instruction set extension with TARGET("avx2") etc., while
+   the rest of the program is built for the baseline architecture; the
+   kernel to use is chosen when the program starts, according to what
+   the CPU supports. Define PDF417_NO_SIMD to build only the portable
+   versions.
+
+*/
+
+#ifndef _PDF417SIMD_H_
+#define _PDF417SIMD_H_
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(PDF417_NO_SIMD)
+#define PDF417_X86_SIMD 1
+#include <immintrin.h>
+#define TARGET(isa)        __attribute__((target(isa)))
+#define CPU_SUPPORTS(isa)  __builtin_cpu_supports(isa)
+#define CPU_INIT()         __builtin_cpu_init()
+#define STARTUP            __attribute__((constructor))
+#endif
+
+#ifdef __GNUC__
+#define ALWAYS_INLINE  inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE  inline
+#endif
+
+#endif /*_PDF417SIMD_H_*/
@@ -0,0 +1,23 @@
+/* pdf417types.h
+
+   Integer types used inside the pdf417decode library. They are not part
+   of the library interface: pdf417decode.h uses the plain C types they
+   stand for.
+
+*/
+
+#ifndef _PDF417TYPES_H_
+#define _PDF417TYPES_H_
+
+typedef unsigned short UInt16;
+typedef unsigned int UInt32;
+typedef int Int32;
+
+/*  You'd better be using gcc, or else an Alpha, or something
+ *  Your compiler needs to understand that "long long" is 64 bits (gcc does)
+ *  in order to compile it.
+ */
+
+typedef unsigned long long UInt64;
+
+#endif /*_PDF417TYPES_H_*/
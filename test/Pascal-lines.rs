@@ -0,0 +1,16 @@
+Total codewords = 480 (448 data, 32 ECC)
+12 codewords not read (the scan stopped early)
+1 codewords corrected
+
+Pascal invented the first digital calculator to help his father with his work
+collecting taxes. He worked on it for three years between 1642 and 1645.
+The device, called the Pascaline, resembled a mechanical calculator of the
+1940's. This, almost certainly, makes Pascal the second person to invent a
+mechanical calculator for Schickard had manufactured one in 1624. 
+
+There were problems faced by Pascal in the design of the calculator which were
+due to the design of the French currency at that time. There were 20 sols in a
+livre and 12 deniers in a sol. The system remained in France until 1799 but in
+Britain a system with similar multiples lasted until 1971. Pascal had to solve
+much harder technical problems to work with this division of the livre into
+240 than he would have had if the division had been 100.